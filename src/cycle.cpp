@@ -20,6 +20,7 @@
 #include<vector>
 #include<string>
 #include<fstream>
+#include<iostream>
 #include<stdexcept>
 #include<future>
 #include<cctype>
@@ -28,6 +29,7 @@
 #include"pluginsocket.h"
 #include"training_data.h"
 #include"results_queue.h"
+#include"thread_pool.h"
 
 using std::map;
 using std::string;
@@ -38,6 +40,8 @@ Cycle::~Cycle() {
         delete _data;
     if (_plugins != nullptr)
         delete _plugins;
+    if (_pool != nullptr)
+        delete _pool;
 }
 
 void Cycle::init(Input *input, Output* output,
@@ -59,33 +63,119 @@ void Cycle::init_chain(const std::string& chain_definition,
 }
 
 void Cycle::start() {
-    ResultsQueue<Normalizer::Result> res(policy);
+    // the workers are kept for the whole run instead of
+    // starting a thread for every line
+    if (_pool == nullptr && policy != std::launch::deferred)
+        _pool = new ThreadPool(_threads);
+    if (_plugins != nullptr && _cache_size > 0) {
+        _plugins->set_cache_size(_cache_size);
+        _plugins->set_caching(true);
+    }
+    if (_plugins != nullptr && !_disk_cache.empty()
+        && settings["normalize"]) {
+        try {
+            _plugins->attach_disk_cache(_disk_cache, _disk_cache_capacity);
+        } catch (const std::runtime_error& e) {
+            std::cerr << "*** WARNING: not using the disk cache: "
+                      << e.what() << std::endl;
+        }
+    }
+    if (settings["dedup"] && settings["normalize"]) {
+        start_dedup();
+        return;
+    }
+    ResultsQueue<Normalizer::Result> res(_pool, policy);
     bool print_prob = settings["prob"];
     Normalizer::LogLevel ll = _max_log_level;
     Output* o = _out;
     auto outputter = [print_prob, ll, o](Normalizer::Result r) {
         o->put_line(&r, print_prob, ll);
     };
-    auto producer = [this](string_impl line) {
-        auto my_result = _plugins->normalize(line);
-        return my_result;
-    };
     res.set_consumer(outputter);
+    // if the input's lines stay valid, they are converted to
+    // string_impl by the workers instead of the reading thread
+    bool stable = _in->stable_lines();
     _in->begin();
     while (!_in->request_quit()) {
-        string_impl line = _in->get_line();
-        if (line.length() == 0)
+        boost::string_ref raw = _in->get_raw_line();
+        if (raw.empty())
             continue;
         if (settings["train"] && _in->request_train()) {
-            training_pair(line);
+            training_pair(from_utf8(raw.data(), raw.size()));
             continue;
         }
-        if (settings["normalize"])
-            res.add_producer(producer, line);
+        if (settings["normalize"]) {
+            if (stable) {
+                res.add_producer([this, raw]() {
+                    return _plugins->normalize(from_utf8(raw.data(),
+                                                         raw.size()));
+                });
+            } else {
+                string_impl line = from_utf8(raw.data(), raw.size());
+                res.add_producer([this, line]() {
+                    return _plugins->normalize(line);
+                });
+            }
+        }
         if (settings["train"] && _out->request_train())
             _plugins->train(_data);
     }
     res.finish();
+    finish_training();
+    _out->flush();
+    _in->end();
+}
+
+void Cycle::start_dedup() {
+    // first pass: read the whole input, remembering only the distinct
+    // types and the type of each token. training pairs are used right
+    // away, so all of them are seen before anything is normalized.
+    // types are kept as raw UTF-8 and only converted once each.
+    std::map<std::string, size_t> type_ids;
+    std::vector<std::string> types;
+    std::vector<size_t> tokens;
+    _in->begin();
+    while (!_in->request_quit()) {
+        boost::string_ref raw = _in->get_raw_line();
+        if (raw.empty())
+            continue;
+        if (settings["train"] && _in->request_train()) {
+            training_pair(from_utf8(raw.data(), raw.size()));
+            continue;
+        }
+        auto inserted = type_ids.insert(std::make_pair(raw.to_string(),
+                                                       types.size()));
+        if (inserted.second)
+            types.push_back(raw.to_string());
+        tokens.push_back(inserted.first->second);
+    }
+    type_ids.clear();
+    finish_training();
+
+    // second pass: normalize every type once
+    std::vector<std::future<Normalizer::Result>> results;
+    results.reserve(types.size());
+    for (const std::string& type : types) {
+        auto task = [this, &type]() {
+            return _plugins->normalize(from_utf8(type.data(), type.size()));
+        };
+        if (_pool == nullptr || policy == std::launch::deferred)
+            results.push_back(std::async(std::launch::deferred, task));
+        else
+            results.push_back(_pool->submit(task));
+    }
+    std::vector<Normalizer::Result> normalized;
+    normalized.reserve(types.size());
+    for (auto& result : results)
+        normalized.push_back(result.get());
+
+    // third pass: write the results in the original order. put_line
+    // consumes the log messages, so every token gets its own copy.
+    for (size_t type : tokens) {
+        Normalizer::Result r = normalized[type];
+        _out->put_line(&r, settings["prob"], _max_log_level);
+    }
+    _out->flush();
     _in->end();
 }
 
@@ -103,12 +193,18 @@ bool Cycle::training_pair(const string_impl& line) {
         extract(line, divpos + 1, line.length(), &modern);
         _data->add_source(word);
         _data->add_target(modern);
-        _plugins->train(_data);
+        if (!settings["batchtrain"])
+            _plugins->train(_data);
         return true;
     }
     return false;
 }
 
+void Cycle::finish_training() {
+    if (settings["batchtrain"])
+        _plugins->train(_data);
+}
+
 void Cycle::save_params() {
     _plugins->save_params();
 }
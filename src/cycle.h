@@ -28,6 +28,7 @@ namespace Norma {
 class Input;
 class Output;
 class PluginSocket;
+class ThreadPool;
 
 /// the main application cycle
 /** This class contains the main loop for input and output.
@@ -58,20 +59,48 @@ class Cycle {
      void set_thread(bool val) {
          policy = val ? std::launch::async : std::launch::deferred;
      }
+     /// set the number of worker threads used for normalization;
+     /// 0 means one per hardware thread. has to be called before start().
+     void set_threads(unsigned n) {
+         _threads = n;
+     }
+     /// cache the final results of the chain for up to n wordforms;
+     /// 0 turns the cache off. has to be called before start().
+     void set_cache_size(size_t n) {
+         _cache_size = n;
+     }
+     /// keep results in a DiskCache file of the given capacity in bytes.
+     /// has to be called before start().
+     void set_disk_cache(const std::string& filename, size_t capacity) {
+         _disk_cache = filename;
+         _disk_cache_capacity = capacity;
+     }
 
  private:
+     /// add a training pair, and train on it unless in batch mode
      bool training_pair(const string_impl& line);
+     /// in batch mode, train on all pairs read from the input at once
+     void finish_training();
+     /// batch mode that normalizes each distinct type only once
+     void start_dedup();
 
      std::map<std::string, std::string> _params;
      Normalizer::LogLevel _max_log_level = Normalizer::LogLevel::WARN;
      std::map<std::string, bool> settings = {
          { "train", true },
          { "normalize", true },
-         { "prob", true } };
+         { "prob", true },
+         { "dedup", false },
+         { "batchtrain", false } };
      TrainingData* _data = nullptr;
      PluginSocket* _plugins = nullptr;
      Input* _in = nullptr;
      Output* _out = nullptr;
+     ThreadPool* _pool = nullptr;
+     unsigned _threads = 0;
+     size_t _cache_size = 0;
+     std::string _disk_cache;
+     size_t _disk_cache_capacity = 0;
 
      std::launch policy = std::launch::async|std::launch::deferred;
 };
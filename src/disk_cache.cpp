@@ -0,0 +1,382 @@
+/* Copyright 2013-2016 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include"disk_cache.h"
+#include<fcntl.h>
+#include<sys/file.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+#include<atomic>
+#include<cstdio>
+#include<cstring>
+#include<fstream>
+#include<mutex>
+#include<queue>
+#include<stdexcept>
+#include<string>
+#include"string_impl.h"
+#include"normalizer/result.h"
+
+namespace Norma {
+namespace {
+const char MAGIC[8] = {'N', 'O', 'R', 'M', 'A', 'C', 'C', 'H'};
+const uint32_t ENDIAN_MARK = 0x01020304;
+
+uint64_t align(uint64_t offset) {
+    return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "shared counters are accessed as std::atomic<uint64_t>");
+
+// fields that other processes may change are accessed atomically
+uint64_t load(const uint64_t* p) {
+    return reinterpret_cast<const std::atomic<uint64_t>*>(p)
+        ->load(std::memory_order_acquire);
+}
+
+void store(uint64_t* p, uint64_t value) {
+    reinterpret_cast<std::atomic<uint64_t>*>(p)
+        ->store(value, std::memory_order_release);
+}
+
+/// holds an exclusive lock on a file while in scope
+class FileLock {
+ public:
+     explicit FileLock(int fd) : _fd(fd) {
+         _locked = (flock(_fd, LOCK_EX) == 0);
+     }
+     ~FileLock() {
+         if (_locked)
+             flock(_fd, LOCK_UN);
+     }
+     bool locked() const { return _locked; }
+
+ private:
+     int _fd;
+     bool _locked;
+};
+
+void put_u32(std::string* out, uint32_t value) {
+    out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void put_string(std::string* out, const std::string& str) {
+    put_u32(out, str.size());
+    out->append(str);
+}
+
+std::string encode(const Normalizer::Result& result) {
+    std::string out;
+    out.append(reinterpret_cast<const char*>(&result.score),
+               sizeof(result.score));
+    put_u32(&out, result.priority);
+    out.push_back(result.is_final ? 1 : 0);
+    put_string(&out, to_utf8(result.word));
+    put_string(&out, result.origin);
+    std::queue<Normalizer::LogMessage> messages = result.messages;
+    put_u32(&out, messages.size());
+    for (; !messages.empty(); messages.pop()) {
+        const Normalizer::LogMessage& m = messages.front();
+        out.push_back(static_cast<char>(std::get<0>(m)));
+        put_string(&out, std::get<1>(m));
+        put_string(&out, std::get<2>(m));
+    }
+    return out;
+}
+
+/// reads encoded values, and fails instead of reading past the end
+class Decoder {
+ public:
+     Decoder(const char* data, size_t len) : _pos(data), _end(data + len) {}
+     bool get(void* out, size_t len) {
+         if (static_cast<size_t>(_end - _pos) < len)
+             return false;
+         memcpy(out, _pos, len);
+         _pos += len;
+         return true;
+     }
+     bool get_string(std::string* out) {
+         uint32_t len;
+         if (!get(&len, sizeof(len)) || static_cast<size_t>(_end - _pos) < len)
+             return false;
+         out->assign(_pos, len);
+         _pos += len;
+         return true;
+     }
+
+ private:
+     const char* _pos;
+     const char* _end;
+};
+
+bool decode(const char* data, size_t len, Normalizer::Result* result) {
+    Decoder d(data, len);
+    Normalizer::Result r;
+    uint8_t is_final;
+    uint32_t n_messages;
+    std::string word;
+    if (!d.get(&r.score, sizeof(r.score))
+        || !d.get(&r.priority, sizeof(r.priority))
+        || !d.get(&is_final, sizeof(is_final))
+        || !d.get_string(&word) || !d.get_string(&r.origin)
+        || !d.get(&n_messages, sizeof(n_messages)))
+        return false;
+    r.word = from_utf8(word.data(), word.size());
+    r.is_final = (is_final != 0);
+    for (uint32_t i = 0; i < n_messages; ++i) {
+        uint8_t level;
+        std::string origin, message;
+        if (!d.get(&level, sizeof(level)) || !d.get_string(&origin)
+            || !d.get_string(&message))
+            return false;
+        r.messages.push(Normalizer::make_message(
+                            static_cast<Normalizer::LogLevel>(level),
+                            origin, message));
+    }
+    *result = r;
+    return true;
+}
+}  // namespace
+
+/// at the start of the file, all offsets are from the start of the file
+struct DiskCache::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t fingerprint;
+    uint64_t file_size;
+    uint64_t n_buckets;
+    /// start of the records
+    uint64_t data;
+    /// end of the records, where the next one is appended
+    uint64_t used;
+    uint64_t entries;
+};
+
+/// followed by key_length bytes of the word as UTF-8, and the encoded
+/// Result; records are chained per hash bucket, newest first
+struct DiskCache::Record {
+    uint64_t next;
+    uint64_t hash;
+    uint32_t key_length;
+    uint32_t value_length;
+    const char* key() const {
+        return reinterpret_cast<const char*>(this + 1);
+    }
+    const char* value() const { return key() + key_length; }
+};
+
+const uint32_t DiskCache::VERSION;
+const size_t DiskCache::DEFAULT_CAPACITY;
+
+DiskCache::DiskCache(const std::string& filename, uint64_t fingerprint,
+                     size_t capacity) : _filename(filename) {
+    // another process may replace the file while we're waiting
+    // for the lock, in which case we have to open the new one
+    while (!open_file(fingerprint, capacity)) {}
+}
+
+DiskCache::~DiskCache() {
+    if (_data != nullptr)
+        munmap(_data, _size);
+    if (_fd >= 0)
+        close(_fd);
+}
+
+bool DiskCache::open_file(uint64_t fingerprint, size_t capacity) {
+    int fd = open(_filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        throw std::runtime_error("couldn't open cache file: " + _filename);
+    FileLock lock(fd);
+    struct stat st, st_name;
+    if (!lock.locked() || fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("couldn't lock cache file: " + _filename);
+    }
+    if (stat(_filename.c_str(), &st_name) != 0
+        || st.st_ino != st_name.st_ino || st.st_dev != st_name.st_dev) {
+        close(fd);
+        return false;
+    }
+
+    Header h;
+    bool valid = static_cast<size_t>(st.st_size) >= sizeof(h)
+        && pread(fd, &h, sizeof(h), 0) == sizeof(h)
+        && memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0
+        && h.version == VERSION && h.byte_order == ENDIAN_MARK
+        && h.fingerprint == fingerprint
+        && h.file_size == static_cast<uint64_t>(st.st_size)
+        // a damaged header would make us write outside the mapping
+        && h.n_buckets != 0 && (h.n_buckets & (h.n_buckets - 1)) == 0
+        && h.data == align(h.data) && h.data >= sizeof(h)
+        && h.n_buckets <= (h.data - sizeof(h)) / sizeof(uint64_t)
+        && h.used == align(h.used)
+        && h.data <= h.used && h.used <= h.file_size;
+    if (!valid) {
+        // replace instead of overwriting, other processes
+        // may still be reading from the old file
+        std::string tmpname = _filename + ".tmp."
+                            + std::to_string(getpid());
+        create_file(tmpname, fingerprint, capacity);
+        if (std::rename(tmpname.c_str(), _filename.c_str()) != 0) {
+            std::remove(tmpname.c_str());
+            close(fd);
+            throw std::runtime_error("couldn't replace cache file: "
+                                     + _filename);
+        }
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("couldn't map cache file: " + _filename);
+    }
+    _fd = fd;
+    _data = static_cast<char*>(data);
+    _size = st.st_size;
+    return true;
+}
+
+void DiskCache::create_file(const std::string& filename,
+                            uint64_t fingerprint, size_t capacity) {
+    Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.byte_order = ENDIAN_MARK;
+    h.fingerprint = fingerprint;
+    h.file_size = capacity;
+    // about one bucket for every 256 bytes of records
+    h.n_buckets = 64;
+    while (h.n_buckets * 2 * 256 <= capacity)
+        h.n_buckets *= 2;
+    h.data = align(sizeof(h) + h.n_buckets * sizeof(uint64_t));
+    h.used = h.data;
+    if (h.data >= capacity)
+        throw std::runtime_error("cache file capacity is too small: "
+                                 + std::to_string(capacity));
+
+    int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("couldn't create cache file: " + filename);
+    // the buckets are zeroed by extending the file
+    bool ok = ftruncate(fd, capacity) == 0
+           && pwrite(fd, &h, sizeof(h), 0) == sizeof(h);
+    close(fd);
+    if (!ok) {
+        std::remove(filename.c_str());
+        throw std::runtime_error("couldn't create cache file: " + filename);
+    }
+}
+
+uint64_t* DiskCache::buckets() const {
+    return reinterpret_cast<uint64_t*>(_data + sizeof(Header));
+}
+
+const DiskCache::Record* DiskCache::find_record(const std::string& key,
+                                                uint64_t hash) const {
+    const Header* h = header();
+    uint64_t offset = load(&buckets()[hash & (h->n_buckets - 1)]);
+    while (offset != 0) {
+        if (offset < h->data || offset + sizeof(Record) > _size)
+            return nullptr;
+        const Record* r = reinterpret_cast<const Record*>(_data + offset);
+        if (offset + sizeof(Record) + r->key_length + r->value_length > _size)
+            return nullptr;
+        if (r->hash == hash && r->key_length == key.size()
+            && memcmp(r->key(), key.data(), key.size()) == 0)
+            return r;
+        // records only ever point to older ones
+        if (r->next >= offset)
+            return nullptr;
+        offset = r->next;
+    }
+    return nullptr;
+}
+
+bool DiskCache::find(const string_impl& word,
+                     Normalizer::Result* result) const {
+    std::string key = to_utf8(word);
+    const Record* r = find_record(key, hash_bytes(key.data(), key.size(), 0));
+    return r != nullptr && decode(r->value(), r->value_length, result);
+}
+
+bool DiskCache::insert(const string_impl& word,
+                       const Normalizer::Result& result) {
+    std::string key = to_utf8(word), value = encode(result);
+    uint64_t hash = hash_bytes(key.data(), key.size(), 0);
+    std::lock_guard<std::mutex> guard(_write_mutex);
+    FileLock lock(_fd);
+    if (!lock.locked() || find_record(key, hash) != nullptr)
+        return false;
+    Header* h = header();
+    uint64_t used = load(&h->used),
+             length = align(sizeof(Record) + key.size() + value.size());
+    if (used < h->data || used + length > _size)
+        return false;
+
+    // write the record first, then make it visible to readers
+    Record* r = reinterpret_cast<Record*>(_data + used);
+    uint64_t* bucket = &buckets()[hash & (h->n_buckets - 1)];
+    r->next = load(bucket);
+    r->hash = hash;
+    r->key_length = key.size();
+    r->value_length = value.size();
+    memcpy(_data + used + sizeof(Record), key.data(), key.size());
+    memcpy(_data + used + sizeof(Record) + key.size(),
+           value.data(), value.size());
+    store(&h->used, used + length);
+    store(bucket, used);
+    store(&h->entries, load(&h->entries) + 1);
+    return true;
+}
+
+uint64_t DiskCache::fingerprint() const {
+    return header()->fingerprint;
+}
+
+size_t DiskCache::size() const {
+    return load(&header()->entries);
+}
+
+uint64_t DiskCache::hash_bytes(const char* data, size_t len, uint64_t seed) {
+    uint64_t h = 14695981039346656037ULL ^ seed;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+uint64_t DiskCache::hash_file(const std::string& filename, uint64_t seed) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::string missing = "<missing>" + filename;
+        return hash_bytes(missing.data(), missing.size(), seed);
+    }
+    uint64_t h = seed;
+    char buffer[1 << 16];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+        h = hash_bytes(buffer, file.gcount(), h);
+    return h;
+}
+}  // namespace Norma
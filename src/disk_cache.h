@@ -0,0 +1,94 @@
+/* Copyright 2013-2016 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DISK_CACHE_H_
+#define DISK_CACHE_H_
+#include<cstddef>
+#include<cstdint>
+#include<mutex>
+#include<string>
+#include"string_impl.h"
+#include"normalizer/result.h"
+
+namespace Norma {
+/// A file of normalization results that persists across runs.
+/** The file is a hash table of (word, Result) records that is mapped
+ *  into memory and only ever appended to.  Lookups read the mapping
+ *  without any locks; insertions are serialized with a file lock, so
+ *  several processes can share the same file at the same time.
+ *
+ *  Every file is tagged with a fingerprint of the parameters that
+ *  produced its results (see PluginSocket::fingerprint()).  When a file
+ *  with a different fingerprint is opened, it is replaced by an empty
+ *  one; processes that still have the old file open keep using it.
+ *
+ *  The file is created with its full capacity, but as a sparse file, so
+ *  it only takes up as much disk space as is actually used.  When it is
+ *  full, new results are no longer stored.
+ **/
+class DiskCache {
+ public:
+     /// open or create a cache file, throws std::runtime_error on failure
+     DiskCache(const std::string& filename, uint64_t fingerprint,
+               size_t capacity = DEFAULT_CAPACITY);
+     DiskCache(const DiskCache& a) = delete;
+     const DiskCache& operator=(const DiskCache& a) = delete;
+     ~DiskCache();
+
+     /// look up a word, returns false if it's not in the cache
+     bool find(const string_impl& word, Normalizer::Result* result) const;
+     /// store the result for a word
+     /** @return false if the word was already stored or the file is full
+      **/
+     bool insert(const string_impl& word, const Normalizer::Result& result);
+
+     uint64_t fingerprint() const;
+     /// size of the file in bytes
+     size_t capacity() const { return _size; }
+     /// number of stored results
+     size_t size() const;
+
+     /// hash some bytes into a fingerprint
+     static uint64_t hash_bytes(const char* data, size_t len,
+                                uint64_t seed);
+     /// hash the contents of a file into a fingerprint; files that
+     /// can't be read are hashed by name only
+     static uint64_t hash_file(const std::string& filename, uint64_t seed);
+
+     static const uint32_t VERSION = 1;
+     static const size_t DEFAULT_CAPACITY = 256 << 20;
+
+ private:
+     struct Header;
+     struct Record;
+     Header* header() const { return reinterpret_cast<Header*>(_data); }
+     uint64_t* buckets() const;
+     const Record* find_record(const std::string& key, uint64_t hash) const;
+     bool open_file(uint64_t fingerprint, size_t capacity);
+     void create_file(const std::string& filename, uint64_t fingerprint,
+                      size_t capacity);
+
+     std::string _filename;
+     int _fd = -1;
+     char* _data = nullptr;
+     size_t _size = 0;
+     /// file locks don't exclude threads of the same process
+     std::mutex _write_mutex;
+};
+}  // namespace Norma
+
+#endif  // DISK_CACHE_H_
@@ -0,0 +1,164 @@
+/* Copyright 2013-2015 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include"acceptor_builder.h"
+#include<algorithm>
+#include<functional>
+#include<stdexcept>
+#include<utility>
+#include<vector>
+#include"gfsmlibs.h"
+#include"compiled_acceptor.h"
+
+namespace Gfsm {
+
+size_t AcceptorBuilder::StateHash::operator()(gfsmStateId id) const {
+    const State& s = (*states)[id];
+    size_t h = s.final ? 1 : 0;
+    for (const Arc& arc : s.arcs) {
+        h = h * 31 + std::hash<gfsmLabelVal>()(arc.first);
+        h = h * 31 + std::hash<gfsmStateId>()(arc.second);
+    }
+    return h;
+}
+
+bool AcceptorBuilder::StateEqual::operator()(gfsmStateId a,
+                                             gfsmStateId b) const {
+    const State& x = (*states)[a];
+    const State& y = (*states)[b];
+    return x.final == y.final && x.arcs == y.arcs;
+}
+
+AcceptorBuilder::AcceptorBuilder()
+    : _register(0, StateHash { &_states }, StateEqual { &_states }) {
+    _path.push_back(new_state());
+}
+
+gfsmStateId AcceptorBuilder::new_state() {
+    if (!_free.empty()) {
+        gfsmStateId id = _free.back();
+        _free.pop_back();
+        return id;
+    }
+    _states.emplace_back();
+    return _states.size() - 1;
+}
+
+void AcceptorBuilder::free_state(gfsmStateId id) {
+    State& s = _states[id];
+    std::vector<Arc>().swap(s.arcs);
+    s.final = false;
+    _free.push_back(id);
+}
+
+void AcceptorBuilder::replace_or_register(size_t depth) {
+    while (_path.size() > depth + 1) {
+        gfsmStateId child = _path.back();
+        _path.pop_back();
+        // registered states never change, so their arcs can be sorted here
+        std::sort(_states[child].arcs.begin(), _states[child].arcs.end());
+        auto equivalent = _register.find(child);
+        if (equivalent != _register.end()) {
+            _states[_path.back()].arcs.back().second = *equivalent;
+            free_state(child);
+        } else {
+            _register.insert(child);
+        }
+    }
+    _last.resize(depth);
+}
+
+bool AcceptorBuilder::add(const std::vector<gfsmLabelVal>& word,
+                          bool partials) {
+    size_t prefix = 0;
+    while (prefix < word.size() && prefix < _last.size()
+           && word[prefix] == _last[prefix])
+        ++prefix;
+    replace_or_register(prefix);
+
+    if (prefix < word.size()) {
+        // if the next arc exists already, it leads to a state that's
+        // registered already, and a word was added out of order
+        for (const Arc& arc : _states[_path.back()].arcs) {
+            if (arc.first == word[prefix])
+                throw std::invalid_argument("AcceptorBuilder: words have "
+                                            "to be added in sorted order");
+        }
+    }
+    if (partials) {
+        for (size_t i = 1; i < _path.size(); ++i)
+            _states[_path[i]].final = true;
+    }
+    for (size_t i = prefix; i < word.size(); ++i) {
+        gfsmStateId target = new_state();
+        _states[_path.back()].arcs.push_back(Arc(word[i], target));
+        _states[target].final = partials;
+        _path.push_back(target);
+    }
+    _last = word;
+
+    State& last = _states[_path.back()];
+    bool added = prefix < word.size() || !last.final;
+    last.final = true;
+    return added;
+}
+
+CompiledAcceptor AcceptorBuilder::finish() {
+    replace_or_register(0);
+    std::sort(_states[_path[0]].arcs.begin(), _states[_path[0]].arcs.end());
+
+    // number the states in breadth-first order, starting at the root
+    std::vector<gfsmStateId> ids(_states.size(), gfsmNoState);
+    std::vector<gfsmStateId> order {_path[0]};
+    ids[_path[0]] = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (const Arc& arc : _states[order[i]].arcs) {
+            if (ids[arc.second] == gfsmNoState) {
+                ids[arc.second] = order.size();
+                order.push_back(arc.second);
+            }
+        }
+    }
+
+    CompiledAcceptor fsa;
+    fsa._offsets.reserve(order.size() + 1);
+    fsa._finals.reserve(order.size());
+    for (gfsmStateId id : order) {
+        const State& s = _states[id];
+        fsa._offsets.push_back(fsa._labels.size());
+        fsa._finals.push_back(s.final ? 1 : 0);
+        for (const Arc& arc : s.arcs) {
+            fsa._labels.push_back(arc.first);
+            fsa._targets.push_back(ids[arc.second]);
+        }
+    }
+    fsa._offsets.push_back(fsa._labels.size());
+    fsa._t.root = 0;
+    fsa._owning = true;
+    fsa._valid = true;
+    fsa.use_own_tables();
+
+    _register.clear();
+    _states.clear();
+    _free.clear();
+    _last.clear();
+    _path.clear();
+    _path.push_back(new_state());
+    return fsa;
+}
+
+}  // namespace Gfsm
@@ -0,0 +1,88 @@
+/* Copyright 2013-2015 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GFSM_ACCEPTOR_BUILDER_H_
+#define GFSM_ACCEPTOR_BUILDER_H_
+#include<cstddef>
+#include<unordered_set>
+#include<utility>
+#include<vector>
+#include"gfsmlibs.h"
+#include"compiled_acceptor.h"
+
+namespace Gfsm {
+
+/// Builds a minimal acyclic acceptor from sorted words in one pass.
+/** Implements the incremental construction for sorted input by
+    Daciuk et al. (2000): once a word is added, the states that only
+    belong to the previous word can't change anymore, so they are
+    merged right away with an equivalent state from a register, or
+    added to it. Only the states on the path of the current word are
+    kept unminimized, so memory stays proportional to the result.
+
+    Words have to come in an order where words with a common prefix
+    are grouped together, which holds for any lexicographic order,
+    e.g. the output of `LC_ALL=C sort`.
+ */
+class AcceptorBuilder {
+ public:
+    AcceptorBuilder();
+    AcceptorBuilder(const AcceptorBuilder& a) = delete;
+    AcceptorBuilder& operator=(const AcceptorBuilder& a) = delete;
+
+    /// Add a word.
+    /** @param partials If true, all prefixes of the word are accepted, too.
+        @return false if the word was accepted already
+        @throw std::invalid_argument if the words aren't sorted
+     */
+    bool add(const std::vector<gfsmLabelVal>& word, bool partials = false);
+    /// Minimize the remaining states and return the result.
+    /** The root of the result is state 0. The builder is empty afterwards.
+     */
+    CompiledAcceptor finish();
+
+ private:
+    typedef std::pair<gfsmLabelVal, gfsmStateId> Arc;
+    struct State {
+        std::vector<Arc> arcs;
+        bool final = false;
+    };
+    struct StateHash {
+        const std::vector<State>* states;
+        size_t operator()(gfsmStateId id) const;
+    };
+    struct StateEqual {
+        const std::vector<State>* states;
+        bool operator()(gfsmStateId a, gfsmStateId b) const;
+    };
+
+    gfsmStateId new_state();
+    void free_state(gfsmStateId id);
+    /// merge or register the states of the previous word below depth
+    void replace_or_register(size_t depth);
+
+    std::vector<State> _states;
+    std::vector<gfsmStateId> _free;
+    std::unordered_set<gfsmStateId, StateHash, StateEqual> _register;
+    /// the previous word, and the states along it starting with the root
+    std::vector<gfsmLabelVal> _last;
+    std::vector<gfsmStateId> _path;
+};
+
+}  // namespace Gfsm
+
+#endif  // GFSM_ACCEPTOR_BUILDER_H_
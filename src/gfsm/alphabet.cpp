@@ -30,6 +30,7 @@ namespace Gfsm {
 
 void Alphabet::clear() {
     _alph.clear();
+    _chars.clear();
     _next_free_label = 1;
     _map_unknown = nullptr;
 }
@@ -52,7 +53,7 @@ void Alphabet::load_labfile(const std::string& filename) {
             throw std::runtime_error("Error parsing labels file!");
         if (label > _next_free_label)
             _next_free_label = label;
-        _alph.insert(AlphabetMapping(symbol, label));
+        insert(symbol, label);
     }
     file.close();
     _next_free_label++;
@@ -71,9 +72,16 @@ void Alphabet::save_labfile(const std::string& filename) const {
     file.close();
 }
 
+void Alphabet::insert(const string_impl& symbol, gfsmLabelVal label) {
+    if (!_alph.insert(AlphabetMapping(symbol, label)).second
+        || symbol.length() != 1)
+        return;
+    _chars[symbol[0]] = label;
+}
+
 void Alphabet::add_mapping(const string_impl& symbol,
                            const gfsmLabelVal& label) {
-    _alph.insert(Alphabet::AlphabetMapping(symbol, label));
+    insert(symbol, label);
     if (label >= _next_free_label)
         _next_free_label = label + 1;
 }
@@ -116,11 +124,9 @@ gfsmLabelVal Alphabet::map_symbol(const string_impl& symbol) const {
 }
 
 LabelVector Alphabet::map_symbols(const string_impl& symbols) const {
-    string_impl c;
     LabelVector vec;
     for (string_size i = 0; i < symbols.length(); ++i) {
-        c = from_char(symbols[i]);
-        gfsmLabelVal val = map_symbol(c);
+        gfsmLabelVal val = map_char(symbols[i]);
         if (val > 0 || !_ignore_unknowns) {
             vec.push_back(val);
         }
@@ -128,6 +134,17 @@ LabelVector Alphabet::map_symbols(const string_impl& symbols) const {
     return vec;
 }
 
+size_t Alphabet::map_symbols(const string_impl& symbols,
+                             gfsmLabelVal* out) const {
+    size_t n = 0;
+    for (string_size i = 0; i < symbols.length(); ++i) {
+        gfsmLabelVal val = map_char(symbols[i]);
+        if (val > 0 || !_ignore_unknowns)
+            out[n++] = val;
+    }
+    return n;
+}
+
 LabelVector
         Alphabet::map_symbols(const std::vector<string_impl>& symbols) const {
     LabelVector vec;
@@ -161,7 +178,11 @@ LabelVector Alphabet::cover(const string_impl& symbols) {
     string_impl c;
     LabelVector vec;
     for (string_size i = 0; i < symbols.length(); ++i) {
-        gfsmLabelVal val;
+        gfsmLabelVal val = char_label(symbols[i]);
+        if (val > 0) {
+            vec.push_back(val);
+            continue;
+        }
         c = from_char(symbols[i]);
         if (contains(c)) {
             val = get_label(c);
@@ -17,6 +17,7 @@
  */
 #ifndef GFSM_ALPHABET_H_
 #define GFSM_ALPHABET_H_
+#include<cstddef>
 #include<set>
 #include<vector>
 #include<string>
@@ -80,6 +81,17 @@ class Alphabet {
         LabelVector; otherwise they are discarded.
      */
     LabelVector map_symbols(const string_impl& symbols) const;
+    /// Map a string with several symbols to labels, without allocating.
+    /** Same as map_symbols(const string_impl&), but writes the labels
+        to out, which needs room for symbols.length() labels.
+        @return The number of labels written.
+     */
+    size_t map_symbols(const string_impl& symbols, gfsmLabelVal* out) const;
+    /// Map a single character to a label, same as map_symbol(from_char(c)).
+    gfsmLabelVal map_char(char_impl c) const {
+        gfsmLabelVal val = char_label(c);
+        return val > 0 ? val : map_symbol(from_char(c));
+    }
     /// Map a vector of symbols to a LabelVector.
     /** Calls map_symbol() for each element of the given vector, and
         combines the results into a LabelVector.  If is_ignore_unknowns()
@@ -133,6 +145,11 @@ class Alphabet {
     typedef boost::bimap<string_impl, gfsmLabelVal> AlphabetBimap;
     typedef AlphabetBimap::value_type AlphabetMapping;
     AlphabetBimap _alph;
+    /// labels of single character symbols
+    DenseCharMap<gfsmLabelVal> _chars;
+    /// label of a single character symbol, or 0 if there is none
+    gfsmLabelVal char_label(char_impl c) const { return _chars.get(c); }
+    void insert(const string_impl& symbol, gfsmLabelVal label);
     unknown_symbol_mapper _map_unknown = nullptr;
     bool _ignore_unknowns = false;
     gfsmLabelVal _next_free_label = 1;
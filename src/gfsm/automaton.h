@@ -26,6 +26,7 @@
 namespace Gfsm {
 class LabelVector;
 class Cascade;
+class CompiledAcceptor;
 
 /// A finite-state automaton.
 /** Implements functions that apply to all types of finite-state
@@ -34,6 +35,7 @@ class Cascade;
  */
 class Automaton {
     friend class Cascade;
+    friend class CompiledAcceptor;
  public:
     Automaton() : Automaton(SemiringType::TROPICAL) {}
     explicit Automaton(SemiringType sr);
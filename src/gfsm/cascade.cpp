@@ -19,6 +19,7 @@
 #include<algorithm>
 #include<mutex>
 #include<set>
+#include<vector>
 #include"gfsmlibs.h"
 #include"automaton.h"
 #include"semiring.h"
@@ -54,31 +55,46 @@ Cascade::Cascade(const Cascade& a) {
 Cascade::Cascade(Cascade&& a) : Cascade() {
     std::swap(_cl,  a._cl);
     std::swap(_csc, a._csc);
+    std::swap(_idle, a._idle);
     std::swap(cascade_mutex, a.cascade_mutex);
 }
 
 Cascade& Cascade::operator=(Cascade a) {
     std::swap(_cl,  a._cl);
     std::swap(_csc, a._csc);
+    std::swap(_idle, a._idle);
     std::swap(cascade_mutex, a.cascade_mutex);
     return *this;
 }
 
 Cascade::~Cascade() throw() {
+    free_lookups();
     // this also frees _csc and its indexed automata:
     if (_cl != nullptr)
         gfsmxl_cascade_lookup_free(_cl);
 }
 
+void Cascade::free_lookups() {
+    for (gfsmxlCascadeLookup* cl : _idle) {
+        // the cascade is shared, and freed along with _cl
+        cl->csc = NULL;
+        gfsmxl_cascade_lookup_free(cl);
+    }
+    _idle.clear();
+}
+
 unsigned int Cascade::get_max_paths() const {
+    std::lock_guard<std::mutex> guard(*cascade_mutex);
     return _cl->max_paths;
 }
 
 unsigned int Cascade::get_max_ops() const {
+    std::lock_guard<std::mutex> guard(*cascade_mutex);
     return _cl->max_ops;
 }
 
 double Cascade::get_max_weight() const {
+    std::lock_guard<std::mutex> guard(*cascade_mutex);
     return _cl->max_w;
 }
 
@@ -98,6 +114,8 @@ void Cascade::set_max_weight(double w) {
 }
 
 void Cascade::append(const Automaton* a) {
+    // lookup objects may hold state that depends on the cascade depth
+    free_lookups();
     gfsmIndexedAutomaton* xfsm = gfsm_automaton_to_indexed(a->_fsm, NULL);
     gfsmxl_cascade_append_indexed(_csc, xfsm);
     _size++;
@@ -110,12 +128,33 @@ void Cascade::sort() {
     gfsmxl_cascade_sort_all(_csc, mask);
 }
 
+gfsmxlCascadeLookup* Cascade::acquire_lookup() const {
+    {
+        std::lock_guard<std::mutex> guard(*cascade_mutex);
+        if (!_idle.empty()) {
+            gfsmxlCascadeLookup* cl = _idle.back();
+            _idle.pop_back();
+            return cl;
+        }
+    }
+    // the limits are set for every lookup
+    gfsmxlCascadeLookup* cl = gfsmxl_cascade_lookup_new();
+    gfsmxl_cascade_lookup_set_cascade(cl, _csc);
+    return cl;
+}
+
+void Cascade::release_lookup(gfsmxlCascadeLookup* cl) const {
+    std::lock_guard<std::mutex> guard(*cascade_mutex);
+    _idle.push_back(cl);
+}
+
+LookupParams Cascade::get_params() const {
+    std::lock_guard<std::mutex> guard(*cascade_mutex);
+    return LookupParams(_cl->max_paths, _cl->max_w, _cl->max_ops);
+}
+
 std::set<Path> Cascade::lookup_nbest(const LabelVector& v) const {
-    std::lock_guard<std::mutex> guard(*cascade_mutex);  // necessary
-    gfsmAutomaton* result_fsm = gfsmxl_cascade_lookup_nbest(_cl, v._vec, NULL);
-    Gfsm::Automaton result(static_cast<SemiringType>(_csc->sr->type));
-    result.set_gfsm_automaton(result_fsm);
-    return result.accepted_paths();
+    return lookup_nbest(v, get_params());
 }
 
 std::set<Path> Cascade::lookup_nbest(const LabelVector& v,
@@ -123,7 +162,25 @@ std::set<Path> Cascade::lookup_nbest(const LabelVector& v,
                                      double max_weight) {
     set_max_paths(max_paths);
     set_max_weight(max_weight);
-    return lookup_nbest(v);
+    // use the limits that were passed, another thread
+    // might have changed the stored ones already
+    return lookup_nbest(v, LookupParams(max_paths, max_weight,
+                                        get_max_ops()));
+}
+
+std::set<Path> Cascade::lookup_nbest(const LabelVector& v,
+                                     const LookupParams& params) const {
+    // no lock needed during the lookup, since every thread
+    // has its own lookup object
+    gfsmxlCascadeLookup* cl = acquire_lookup();
+    cl->max_paths = params.max_paths;
+    cl->max_w     = params.max_weight;
+    cl->max_ops   = params.max_ops;
+    gfsmAutomaton* result_fsm = gfsmxl_cascade_lookup_nbest(cl, v._vec, NULL);
+    release_lookup(cl);
+    Gfsm::Automaton result(static_cast<SemiringType>(_csc->sr->type));
+    result.set_gfsm_automaton(result_fsm);
+    return result.accepted_paths();
 }
 }  // namespace Gfsm
 
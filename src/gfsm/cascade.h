@@ -20,6 +20,8 @@
 #include<mutex>
 #include<set>
 #include<memory>
+#include<vector>
+#include<limits>
 #include"gfsmlibs.h"
 #include"semiring.h"
 #include"labelvector.h"
@@ -28,9 +30,29 @@
 namespace Gfsm {
 class Automaton;
 
+/// Limits for a single cascade lookup.
+struct LookupParams {
+    /// Maximum number of paths returned.
+    unsigned int max_paths = 1;
+    /// Maximum weight of the returned paths.
+    double max_weight = 0.0;
+    /// Maximum number of operations during lookup.
+    unsigned int max_ops = std::numeric_limits<unsigned int>::max();
+
+    LookupParams() = default;
+    LookupParams(unsigned int paths, double weight,
+                 unsigned int ops = std::numeric_limits<unsigned int>::max())
+        : max_paths(paths), max_weight(weight), max_ops(ops) {}
+};
+
 /// A cascade of finite-state automata.
 /** Implements functions related to the cascade functionality of the
     Gfsmxl extension to the Gfsm library.
+
+    Lookups can run in parallel. The cascade itself is only read
+    during lookup, but each running lookup needs its own
+    gfsmxlCascadeLookup object for its search state, so these are
+    kept in a pool and reused.
  */
 class Cascade {
  public:
@@ -54,6 +76,8 @@ class Cascade {
     void set_max_ops(unsigned int n);
     /// Get the maximum number of operations allowed during lookup.
     unsigned int get_max_ops() const;
+    /// Get all stored lookup limits.
+    LookupParams get_params() const;
 
     /// Append an automaton to the cascade.
     /** @param a The automaton to be appended.  Internally, a copy of
@@ -74,6 +98,16 @@ class Cascade {
      */
     std::set<Path> lookup_nbest(const LabelVector& v) const;
     /// Finds the n-best paths for a given input sequence.
+    /** The stored limits are neither used nor changed, so concurrent
+        lookups with different limits don't interfere.
+        @param v Input sequence for the cascade
+        @param params Limits for this lookup
+        @return The set of Path objects accepted by this cascade
+                with the lowest weights, depending on params.
+     */
+    std::set<Path> lookup_nbest(const LabelVector& v,
+                                const LookupParams& params) const;
+    /// Finds the n-best paths for a given input sequence.
     /** @param v Input sequence for the cascade
         @param max_paths Maximum number of Paths to be returned;
                          this setting is stored for future lookups.
@@ -87,9 +121,19 @@ class Cascade {
                                 double max_weight);
 
  protected:
+    /// take a lookup object from the pool, or create a new one
+    gfsmxlCascadeLookup* acquire_lookup() const;
+    /// put a lookup object back into the pool
+    void release_lookup(gfsmxlCascadeLookup* cl) const;
+    void free_lookups();
+
+    /// guards the limits in _cl and the pool
     std::unique_ptr<std::mutex> cascade_mutex;
     gfsmxlCascade* _csc;
+    /// holds the stored limits and owns _csc; not used for lookups
     gfsmxlCascadeLookup* _cl;
+    /// lookup objects that are not currently in use
+    mutable std::vector<gfsmxlCascadeLookup*> _idle;
     unsigned int _size = 0;
 };
 
@@ -0,0 +1,151 @@
+/* Copyright 2013-2015 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include"compiled_acceptor.h"
+#include<algorithm>
+#include<utility>
+#include<vector>
+#include"gfsmlibs.h"
+#include"acceptor.h"
+#include"labelvector.h"
+
+namespace Gfsm {
+
+CompiledAcceptor::CompiledAcceptor(const Acceptor& fsa) : _owning(true) {
+    _valid = compile(fsa);
+    if (!_valid) {
+        _offsets.clear();
+        _labels.clear();
+        _targets.clear();
+        _finals.clear();
+    }
+    use_own_tables();
+    if (!_valid)
+        _t.root = gfsmNoState;
+}
+
+CompiledAcceptor::CompiledAcceptor(const Tables& tables)
+    : _t(tables), _owning(false), _valid(true) {}
+
+CompiledAcceptor::CompiledAcceptor(CompiledAcceptor&& a) {
+    *this = std::move(a);
+}
+
+CompiledAcceptor& CompiledAcceptor::operator=(CompiledAcceptor&& a) {
+    _offsets = std::move(a._offsets);
+    _labels  = std::move(a._labels);
+    _targets = std::move(a._targets);
+    _finals  = std::move(a._finals);
+    _t       = a._t;
+    _owning  = a._owning;
+    _valid   = a._valid;
+    if (_owning)
+        use_own_tables();
+    a._t = Tables();
+    a._valid = false;
+    return *this;
+}
+
+void CompiledAcceptor::use_own_tables() {
+    gfsmStateId root = _t.root;
+    _t = Tables();
+    _t.root = root;
+    _t.n_states = _finals.size();
+    if (_t.n_states == 0)
+        return;
+    _t.offsets = _offsets.data();
+    _t.labels  = _labels.data();
+    _t.targets = _targets.data();
+    _t.finals  = _finals.data();
+}
+
+bool CompiledAcceptor::compile(const Acceptor& fsa) {
+    gfsmAutomaton* fsm = fsa._fsm;
+    _t.root = gfsm_automaton_get_root(fsm);
+    gfsmStateId n_states = gfsm_automaton_n_states(fsm);
+    _offsets.reserve(n_states + 1);
+    _finals.resize(n_states, 0);
+    std::vector<std::pair<gfsmLabelVal, gfsmStateId>> arcs;
+    for (gfsmStateId state = 0; state < n_states; ++state) {
+        _offsets.push_back(_labels.size());
+        if (!gfsm_automaton_has_state(fsm, state))
+            continue;
+        _finals[state] = gfsm_automaton_state_is_final(fsm, state) ? 1 : 0;
+        arcs.clear();
+        gfsmArcIter iter;
+        for (gfsm_arciter_open(&iter, fsm, state);
+             gfsm_arciter_ok(&iter);
+             gfsm_arciter_next(&iter)) {
+            gfsmArc* arc = gfsm_arciter_arc(&iter);
+            arcs.push_back(std::make_pair(arc->lower, arc->target));
+        }
+        gfsm_arciter_close(&iter);
+        std::sort(arcs.begin(), arcs.end());
+        for (size_t i = 0; i < arcs.size(); ++i) {
+            // epsilon arcs or several arcs with the same label
+            // would need more than one active state
+            if (arcs[i].first == EPSILON_LABEL
+                || (i > 0 && arcs[i].first == arcs[i-1].first))
+                return false;
+            _labels.push_back(arcs[i].first);
+            _targets.push_back(arcs[i].second);
+        }
+    }
+    _offsets.push_back(_labels.size());
+    return true;
+}
+
+gfsmStateId CompiledAcceptor::step(gfsmStateId state,
+                                   gfsmLabelVal label) const {
+    if (state >= _t.n_states)
+        return gfsmNoState;
+    const gfsmLabelVal* first = _t.labels + _t.offsets[state];
+    const gfsmLabelVal* last  = _t.labels + _t.offsets[state + 1];
+    const gfsmLabelVal* pos = std::lower_bound(first, last, label);
+    if (pos == last || *pos != label)
+        return gfsmNoState;
+    return _t.targets[pos - _t.labels];
+}
+
+bool CompiledAcceptor::accepts(const LabelVector& vec) const {
+    gfsmStateId state = _t.root;
+    for (gfsmLabelVal label : vec) {
+        state = step(state, label);
+        if (state == gfsmNoState)
+            return false;
+    }
+    return is_final(state);
+}
+
+void CompiledAcceptor::to_acceptor(Acceptor* fsa) const {
+    gfsmAutomaton* fsm = fsa->_fsm;
+    gfsmWeight one = fsm->sr->one;
+    for (gfsmStateId state = 0; state < _t.n_states; ++state) {
+        for (uint32_t arc = _t.offsets[state]; arc < _t.offsets[state + 1];
+             ++arc)
+            gfsm_automaton_add_arc(fsm, state, _t.targets[arc],
+                                   _t.labels[arc], _t.labels[arc], one);
+        if (_t.finals[state])
+            gfsm_automaton_set_final_state_full(fsm, state, TRUE, one);
+    }
+    if (_t.root != gfsmNoState) {
+        gfsm_automaton_set_root(fsm, _t.root);
+        fsa->_root = _t.root;
+    }
+}
+
+}  // namespace Gfsm
@@ -0,0 +1,105 @@
+/* Copyright 2013-2015 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GFSM_COMPILED_ACCEPTOR_H_
+#define GFSM_COMPILED_ACCEPTOR_H_
+#include<cstdint>
+#include<vector>
+#include"gfsmlibs.h"
+
+namespace Gfsm {
+class Acceptor;
+class LabelVector;
+
+/// A read-only copy of a deterministic Acceptor as a flat transition table.
+/** The arcs of all states are stored in two arrays sorted by state and
+    label, with an offset array pointing to the first arc of each state
+    (compressed sparse rows). Walking the table doesn't allocate or
+    lock anything, so it's safe and cheap to use from many threads.
+
+    Only deterministic, epsilon-free acceptors can be compiled; for
+    others, is_valid() returns false and the Acceptor has to be used
+    instead.
+
+    The tables can also live in memory owned by someone else, e.g. a
+    mapped file, in which case that memory has to outlive the object.
+ */
+class CompiledAcceptor {
+ public:
+    /// The transition tables, which don't contain any pointers
+    /// themselves and can be written to a file as they are.
+    struct Tables {
+        /// index of the first arc of each state, n_states + 1 entries
+        const uint32_t* offsets = nullptr;
+        /// labels of all arcs, sorted within each state
+        const gfsmLabelVal* labels = nullptr;
+        /// target states of all arcs
+        const gfsmStateId* targets = nullptr;
+        /// 1 for final states, n_states entries
+        const char* finals = nullptr;
+        uint32_t n_states = 0;
+        gfsmStateId root = gfsmNoState;
+
+        uint32_t n_arcs() const {
+            return n_states == 0 ? 0 : offsets[n_states];
+        }
+    };
+
+    CompiledAcceptor() = default;
+    explicit CompiledAcceptor(const Acceptor& fsa);
+    /// use tables that are owned by someone else
+    explicit CompiledAcceptor(const Tables& tables);
+    CompiledAcceptor(const CompiledAcceptor& a) = delete;
+    CompiledAcceptor& operator=(const CompiledAcceptor& a) = delete;
+    CompiledAcceptor(CompiledAcceptor&& a);
+    CompiledAcceptor& operator=(CompiledAcceptor&& a);
+
+    /// false if the acceptor couldn't be compiled
+    bool is_valid() const { return _valid; }
+    /// the initial state, or gfsmNoState if there is none
+    gfsmStateId root() const { return _t.root; }
+    /// follow the arc with the given label
+    /** @return the target state, or gfsmNoState if there is no such arc
+     */
+    gfsmStateId step(gfsmStateId state, gfsmLabelVal label) const;
+    bool is_final(gfsmStateId state) const {
+        return state < _t.n_states && _t.finals[state];
+    }
+    /// same as Acceptor::accepts()
+    bool accepts(const LabelVector& vec) const;
+    const Tables& tables() const { return _t; }
+    /// add all states and arcs to an (empty) Acceptor
+    void to_acceptor(Acceptor* fsa) const;
+
+ private:
+    friend class AcceptorBuilder;
+    bool compile(const Acceptor& fsa);
+    /// point the tables to the owned vectors
+    void use_own_tables();
+
+    Tables _t;
+    std::vector<uint32_t> _offsets;
+    std::vector<gfsmLabelVal> _labels;
+    std::vector<gfsmStateId> _targets;
+    std::vector<char> _finals;
+    bool _owning = false;
+    bool _valid = false;
+};
+
+}  // namespace Gfsm
+
+#endif  // GFSM_COMPILED_ACCEPTOR_H_
@@ -60,18 +60,31 @@ void StringCascade::append(Lexicon* lex) {
 }
 
 std::set<StringPath> StringCascade::lookup_nbest(const string_impl& str) const {
-    return find_map_nbest(_alph_in.map_symbols(str));
+    return lookup_nbest(str, get_params());
 }
 
 std::set<StringPath>
 StringCascade::lookup_nbest(const std::vector<string_impl>& str) const {
-    return find_map_nbest(_alph_in.map_symbols(str));
+    return lookup_nbest(str, get_params());
 }
 
 std::set<StringPath>
-StringCascade::find_map_nbest(const LabelVector& vec) const {
+StringCascade::lookup_nbest(const string_impl& str,
+                            const LookupParams& params) const {
+    return find_map_nbest(_alph_in.map_symbols(str), params);
+}
+
+std::set<StringPath>
+StringCascade::lookup_nbest(const std::vector<string_impl>& str,
+                            const LookupParams& params) const {
+    return find_map_nbest(_alph_in.map_symbols(str), params);
+}
+
+std::set<StringPath>
+StringCascade::find_map_nbest(const LabelVector& vec,
+                              const LookupParams& params) const {
     std::set<StringPath> results;
-    std::set<Path> paths = Cascade::lookup_nbest(vec);
+    std::set<Path> paths = Cascade::lookup_nbest(vec, params);
     for (const Path& p : paths) {
         results.insert(StringPath::from(p, _alph_in, _alph_out));
     }
@@ -83,7 +96,8 @@ StringCascade::lookup_nbest(const std::vector<string_impl>& str,
                             unsigned int max_paths, double max_weight) {
     set_max_paths(max_paths);
     set_max_weight(max_weight);
-    return lookup_nbest(str);
+    return lookup_nbest(str, LookupParams(max_paths, max_weight,
+                                          get_max_ops()));
 }
 
 std::set<StringPath>
@@ -91,6 +105,7 @@ StringCascade::lookup_nbest(const string_impl& str,
                             unsigned int max_paths, double max_weight) {
     set_max_paths(max_paths);
     set_max_weight(max_weight);
-    return lookup_nbest(str);
+    return lookup_nbest(str, LookupParams(max_paths, max_weight,
+                                          get_max_ops()));
 }
 }  // namespace Gfsm
@@ -65,6 +65,16 @@ class StringCascade : public Cascade {
     std::set<StringPath> lookup_nbest(const std::vector<string_impl>& str)
                                                                      const;
     /// Finds the n-best paths for a given input sequence.
+    /** @see Cascade::lookup_nbest(const LabelVector&,
+                                   const LookupParams&) const */
+    std::set<StringPath> lookup_nbest(const string_impl& str,
+                                      const LookupParams& params) const;
+    /// Finds the n-best paths for a given input sequence.
+    /** @see Cascade::lookup_nbest(const LabelVector&,
+                                   const LookupParams&) const */
+    std::set<StringPath> lookup_nbest(const std::vector<string_impl>& str,
+                                      const LookupParams& params) const;
+    /// Finds the n-best paths for a given input sequence.
     /** @see Cascade::lookup_nbest(const LabelVector&, unsigned int, double) */
     std::set<StringPath> lookup_nbest(const string_impl& str,
                                       unsigned int max_paths,
@@ -74,12 +84,24 @@ class StringCascade : public Cascade {
     std::set<StringPath> lookup_nbest(const std::vector<string_impl>& str,
                                       unsigned int max_paths,
                                       double max_weight);
+    /// Finds the n-best paths for input that is already mapped to labels.
+    /** The labels must come from get_input_alphabet().
+        @see Cascade::lookup_nbest(const LabelVector&,
+                                   const LookupParams&) const */
+    std::set<StringPath> lookup_nbest_labels(const LabelVector& labels,
+                                             const LookupParams& params) const {
+        return find_map_nbest(labels, params);
+    }
+
+    /// Get the alphabet used to map input symbols.
+    const Alphabet& get_input_alphabet() const { return _alph_in; }
 
  protected:
     Alphabet _alph_in;
     Alphabet _alph_out;
 
-    std::set<StringPath> find_map_nbest(const LabelVector& vec) const;
+    std::set<StringPath> find_map_nbest(const LabelVector& vec,
+                                        const LookupParams& params) const;
 };
 
 }  // namespace Gfsm
@@ -100,4 +100,15 @@ void StringTransducer::add_path(const StringPath& path,
                          cyclic, final);
 }
 
+void StringTransducer::add_cyclic_replacements(
+                                   const std::set<string_impl>& inputs,
+                                   const std::set<string_impl>& outputs,
+                                   double weight, bool final) {
+    std::vector<string_impl> in(inputs.begin(), inputs.end()),
+                             out(outputs.begin(), outputs.end());
+    Transducer::add_cyclic_replacements(_alph_in.map_symbols(in),
+                                        _alph_out.map_symbols(out),
+                                        weight, final);
+}
+
 }  // namespace Gfsm
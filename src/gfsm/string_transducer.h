@@ -96,6 +96,14 @@ class StringTransducer : public Transducer {
     /** Convenience function for add_path() with cyclic=true. */
     void add_cyclic_path(const StringPath& path, bool final = true)
         { add_path(path, true, final); }
+    using Transducer::add_cyclic_replacements;
+    /// Add cyclic paths that replace any input by any output symbol.
+    /** Identical to Transducer::add_cyclic_replacements(), but takes
+        sets of symbols instead of labels.
+     */
+    void add_cyclic_replacements(const std::set<string_impl>& inputs,
+                                 const std::set<string_impl>& outputs,
+                                 double weight, bool final = true);
 
  protected:
     Alphabet _alph_in;
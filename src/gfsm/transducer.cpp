@@ -67,4 +67,29 @@ void Transducer::add_path(const Path& p, bool cyclic, bool final) {
         gfsm_automaton_set_final_state_full(_fsm, from, TRUE, _fsm->sr->one);
     }
 }
+
+void Transducer::add_cyclic_replacements(const LabelVector& inputs,
+                                         const LabelVector& outputs,
+                                         double weight, bool final) {
+    gfsmStateId from = root();
+    gfsmStateId via  = gfsm_automaton_n_states(_fsm);
+    bool has_input = false, has_output = false;
+    for (gfsmLabelVal in : inputs)
+        has_input = has_input || in != EPSILON_LABEL;
+    for (gfsmLabelVal out : outputs)
+        has_output = has_output || out != EPSILON_LABEL;
+    if (!has_input || !has_output)
+        return;
+    // the weight goes on the input arc, so it counts as early as possible
+    for (gfsmLabelVal in : inputs)
+        if (in != EPSILON_LABEL)
+            gfsm_automaton_add_arc(_fsm, from, via, in, EPSILON_LABEL, weight);
+    for (gfsmLabelVal out : outputs)
+        if (out != EPSILON_LABEL)
+            gfsm_automaton_add_arc(_fsm, via, from, EPSILON_LABEL, out,
+                                   _fsm->sr->one);
+    if (final && (gfsm_automaton_state_is_final(_fsm, from) == FALSE)) {
+        gfsm_automaton_set_final_state_full(_fsm, from, TRUE, _fsm->sr->one);
+    }
+}
 }  // namespace Gfsm
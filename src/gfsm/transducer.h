@@ -64,6 +64,19 @@ class Transducer : public Automaton {
      */
     void add_cyclic_path(const Path& p, bool final = true)
         { add_path(p, true, final); }
+
+    /// Add cyclic paths that replace any input label by any output label.
+    /** Has the same effect as adding a cyclic path for every pair of
+        labels from inputs and outputs with the given weight, but the
+        pairs share an intermediate state: the input is read on one arc,
+        the output written on another.  This needs only
+        inputs.size() + outputs.size() arcs instead of their product.
+        Epsilon labels are ignored.
+        @param final See add_path()
+     */
+    void add_cyclic_replacements(const LabelVector& inputs,
+                                 const LabelVector& outputs,
+                                 double weight, bool final = true);
 };
 
 }  // namespace Gfsm
@@ -20,6 +20,8 @@
 #include"gfsm/automaton.h"
 #include"gfsm/acceptor.h"
 #include"gfsm/string_acceptor.h"
+#include"gfsm/compiled_acceptor.h"
+#include"gfsm/acceptor_builder.h"
 #include"gfsm/transducer.h"
 #include"gfsm/string_transducer.h"
 #include"gfsm/cascade.h"
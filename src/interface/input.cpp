@@ -16,6 +16,11 @@
  * with Norma.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include"input.h"
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+#include<cstring>
 #include<string>
 #include<iostream>
 #include<stdexcept>
@@ -27,9 +32,13 @@ using std::string;
 namespace Norma {
 ///////////////////////////// Input //////////////////////////////////////
 string_impl Input::get_line() {
-    std::string l;
-    getline(*_input, l);
-    return l;
+    boost::string_ref l = get_raw_line();
+    return from_utf8(l.data(), l.size());
+}
+
+boost::string_ref Input::get_raw_line() {
+    getline(*_input, _buffer);
+    return _buffer;
 }
 
 //////////////////////////// FileInput ///////////////////////////////////
@@ -51,11 +60,57 @@ FileInput::~FileInput() {
     }
 }
 
-string_impl FileInput::get_line() {
-    string_impl line = Input::get_line();
-    _request_train = (string_find(line, "\t") != string_npos);
+boost::string_ref FileInput::get_raw_line() {
+    boost::string_ref line = Input::get_raw_line();
+    _request_train = (memchr(line.data(), '\t', line.size()) != nullptr);
     return line;
 }
 
+//////////////////////////// MappedFileInput /////////////////////////////
+MappedFileInput::MappedFileInput(const std::string& fname)
+    : Input() {
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Could not open input file!");
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        throw std::runtime_error("Input file is not a regular file!");
+    }
+    _size = st.st_size;
+    if (_size > 0) {  // mapping an empty file fails
+        void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Could not map input file!");
+        }
+        madvise(data, _size, MADV_SEQUENTIAL);
+        _data = static_cast<const char*>(data);
+    }
+    // the mapping stays valid after closing the descriptor
+    close(fd);
+}
+
+MappedFileInput::~MappedFileInput() {
+    if (_data != nullptr)
+        munmap(const_cast<char*>(_data), _size);
+}
+
+boost::string_ref MappedFileInput::get_raw_line() {
+    if (_pos >= _size) {
+        _request_train = false;
+        return boost::string_ref();
+    }
+    // memchr is vectorized by the C library, so this is a lot
+    // faster than looking at every byte ourselves
+    const char* begin = _data + _pos;
+    size_t rest = _size - _pos;
+    const char* end = static_cast<const char*>(memchr(begin, '\n', rest));
+    size_t len = (end == nullptr) ? rest : end - begin;
+    _pos += len + 1;
+    _request_train = (memchr(begin, '\t', len) != nullptr);
+    return boost::string_ref(begin, len);
+}
+
 }  // namespace Norma
 
@@ -20,6 +20,7 @@
 #include<string>
 #include<fstream>
 #include<iosfwd>
+#include<boost/utility/string_ref.hpp>  //NOLINT[build/include_order]
 #include"string_impl.h"
 #include"iobase.h"
 
@@ -51,6 +52,15 @@ class Input : public IOBase {
      /// the actual function that reads a line and passes it
      /// to Cycle
      virtual string_impl get_line();
+     /// read a line without converting it to string_impl
+     /** Returns the UTF-8 bytes of the line, without the newline.
+      *  Unless stable_lines() is true, the returned view is only
+      *  valid until the next line is read.
+      **/
+     virtual boost::string_ref get_raw_line();
+     /// whether views returned by get_raw_line() stay valid for
+     /// the lifetime of the Input object
+     virtual bool stable_lines() const { return false; }
      /// method to check if the Input requested program termination
      virtual bool request_quit() = 0;
  protected:
@@ -58,6 +68,7 @@ class Input : public IOBase {
          _training->add_source(line);
      }
      std::istream *_input;
+     std::string _buffer;
 };
 
 /// Input from a file
@@ -65,7 +76,7 @@ class FileInput : public Input {
  public:
      explicit FileInput(const std::string& fname);
      ~FileInput();
-     string_impl get_line();
+     boost::string_ref get_raw_line();
      inline bool request_quit() {
          return _input->eof();
      }
@@ -77,6 +88,33 @@ class FileInput : public Input {
      std::ostream *_output, *_error;
 };
 
+/// Input from a memory-mapped file
+/** The file is mapped read-only as a whole, and lines are handed out
+ *  as views into the mapping, so reading a line doesn't copy or
+ *  convert anything. Only works for regular files.
+ **/
+class MappedFileInput : public Input {
+ public:
+     explicit MappedFileInput(const std::string& fname);
+     MappedFileInput(const MappedFileInput& a) = delete;
+     const MappedFileInput& operator=(const MappedFileInput& a) = delete;
+     ~MappedFileInput();
+     boost::string_ref get_raw_line();
+     bool stable_lines() const {
+         return true;
+     }
+     inline bool request_quit() {
+         return _pos >= _size;
+     }
+     bool thread_suitable() {
+         return true;
+     }
+ private:
+     const char* _data = nullptr;
+     size_t _size = 0;
+     size_t _pos = 0;
+};
+
 }  // namespace Norma
 #endif  // INTERFACE_INPUT_H_
 
@@ -16,6 +16,7 @@
  * with Norma.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include"output.h"
+#include<cstdio>
 #include<iostream>
 #include<string>
 #include"normalizer/result.h"
@@ -25,28 +26,113 @@ using std::string;
 namespace Norma {
 //////////////////////////// Output //////////////////////////////////////
 
+constexpr size_t Output::chunk_size;
+constexpr size_t Output::max_pending;
+
 Output::Output() {
     _output = &std::cout;
+    _pending.reserve(chunk_size);
+    _writer = std::thread(&Output::write_chunks, this);
+}
+
+Output::~Output() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _chunk_ready.notify_one();
+    _writer.join();
 }
 
 void Output::put_line(Normalizer::Result* result,
                       bool print_prob, Normalizer::LogLevel max_level) {
-    *_output << result->word;
-    if (print_prob)
-        *_output << "\t" << result->score;
-    *_output << std::endl;
-    log_messages(result, max_level);
+    // format outside the lock, the buffer is reused across lines
+    thread_local std::string line;
+    line.clear();
+    append_utf8(result->word, &line);
+    if (print_prob) {
+        // printf's %g gives the same as the default ostream formatting
+        char score[32];
+        int len = snprintf(score, sizeof(score), "%g", result->score);
+        line += '\t';
+        line.append(score, len);
+    }
+    line += '\n';
+    log_messages(result, max_level, &line);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _chunk_written.wait(lock, [this] {
+        return _pending.size() < max_pending;
+    });
+    _pending += line;
+    if (_pending.size() >= chunk_size)
+        _chunk_ready.notify_one();
+}
+
+void Output::flush() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    size_t ticket = ++_flushes_requested;
+    _chunk_ready.notify_one();
+    _chunk_written.wait(lock, [this, ticket] {
+        return _flushes_done >= ticket;
+    });
+}
+
+void Output::set_flush_interval(std::chrono::milliseconds interval) {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _flush_interval = interval;
+    }
+    _chunk_ready.notify_one();
+}
+
+void Output::write_chunks() {
+    std::string chunk;
+    chunk.reserve(chunk_size);
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (; ;) {
+        auto ready = [this] {
+            return _stopping || _flushes_done < _flushes_requested
+                || _pending.size() >= chunk_size;
+        };
+        if (_flush_interval.count() > 0)
+            _chunk_ready.wait_for(lock, _flush_interval, ready);
+        else
+            _chunk_ready.wait(lock, ready);
+        // everything up to here is written by this round
+        size_t flushes = _flushes_requested;
+        bool stopping = _stopping;
+        chunk.swap(_pending);
+        lock.unlock();
+        if (!chunk.empty()) {
+            _output->write(chunk.data(), chunk.size());
+            _output->flush();
+            chunk.clear();
+        }
+        lock.lock();
+        _flushes_done = flushes;
+        _chunk_written.notify_all();
+        if (stopping && _pending.empty())
+            return;
+    }
 }
 
 void Output::log_messages(Normalizer::Result* result,
-                          Normalizer::LogLevel max_level) {
+                          Normalizer::LogLevel max_level,
+                          std::string* buffer) {
     while (!result->messages.empty()) {
         Normalizer::LogLevel level;
         std::string origin, message;
         std::tie(level, origin, message) = result->messages.front();
-        if (level >= max_level)
-            *_output << "[" << Normalizer::level_string(level) << "]:"
-                     << message << " Origin: " << origin << std::endl;
+        if (level >= max_level) {
+            *buffer += "[";
+            *buffer += Normalizer::level_string(level);
+            *buffer += "]:";
+            *buffer += message;
+            *buffer += " Origin: ";
+            *buffer += origin;
+            *buffer += '\n';
+        }
         result->messages.pop();
     }
 }
@@ -19,20 +19,41 @@
 #define INTERFACE_OUTPUT_H_
 #include<string>
 #include<iosfwd>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<chrono>
 #include"iobase.h"
 #include"normalizer/result.h"
 
 namespace Norma {
 /// Basic Output class. Not pure virtual since it's essentially
 /// non-interactive output already.
+/** Lines are formatted into a buffer, which is handed to a writer
+ *  thread in large chunks, so the output device isn't flushed for
+ *  every line. Buffered output is written
+ *   - when a chunk is full,
+ *   - when flush() is called, which Cycle does at the end of input,
+ *   - at the latest after the flush interval, if one is set.
+ **/
 class Output : public IOBase {
  public:
      Output();
-     virtual ~Output() = default;
+     Output(const Output& a) = delete;
+     const Output& operator=(const Output& a) = delete;
+     /// writes everything that is still buffered
+     virtual ~Output();
      /// put a line on the output device and record it in the history
      virtual void put_line(Normalizer::Result* result,
                            bool print_prob,
                            Normalizer::LogLevel max_level);
+     /// write all buffered lines and wait until they are written
+     virtual void flush();
+     /// maximum time that lines may stay in the buffer.
+     /** 0 means they are only written when a chunk is full
+      *  or on flush(), which is best for non-interactive use.
+      **/
+     void set_flush_interval(std::chrono::milliseconds interval);
      bool thread_suitable() {
          return true;
      }
@@ -41,9 +62,25 @@ class Output : public IOBase {
      virtual void store_line(const string_impl& line) {
          _training->add_target(line);
      }
+     /// append the messages of result to buffer
      virtual void log_messages(Normalizer::Result* result,
-                               Normalizer::LogLevel max_level);
+                               Normalizer::LogLevel max_level,
+                               std::string* buffer);
      std::ostream *_output;
+
+ private:
+     void write_chunks();
+     /// chunks are handed to the writer once they reach this size
+     static constexpr size_t chunk_size = 1 << 16;
+     /// put_line blocks while this much output is waiting
+     static constexpr size_t max_pending = 16 * chunk_size;
+     std::string _pending;
+     std::chrono::milliseconds _flush_interval{0};
+     size_t _flushes_requested = 0, _flushes_done = 0;
+     bool _stopping = false;
+     std::mutex _mutex;
+     std::condition_variable _chunk_ready, _chunk_written;
+     std::thread _writer;
 };
 
 }  // namespace Norma
@@ -58,7 +58,9 @@ void Lexicon::do_set_from_params(const std::map<std::string, std::string>&
 }
 
 void Lexicon::do_init() {
-    if (_lexfile.empty() != _symfile.empty()) {
+    // images bring their own alphabet
+    if (_lexfile.empty() != _symfile.empty()
+        && !(_symfile.empty() && LexiconImage::is_image(_lexfile.string()))) {
         throw std::runtime_error
             ("Error initializing lexicon: please specify either both fsmfile "
              "and symfile or none.");
@@ -68,8 +70,13 @@ void Lexicon::do_init() {
     if (!_symfile.empty() && !boost::filesystem::exists(_symfile)) {
         throw init_error(
             "couldn't find lexicon symbol table: " + _symfile.string());
+    } else if (LexiconImage::is_image(_lexfile.string())) {
+        load_image();
+        _entry_count = -1;
     } else if (boost::filesystem::exists(_lexfile)) {
         _fsm->load_binfile(_lexfile.string());
+        _compiled_stale = true;
+        _entry_count = -1;
     } else if (!_lexfile.empty()) {
         throw init_error(
             "couldn't find lexicon automaton file: " + _lexfile.string());
@@ -79,20 +86,78 @@ void Lexicon::do_init() {
 void Lexicon::do_clear() {
     if (_fsm != nullptr)
         delete _fsm;
+    _image.reset();
     _fsm  = new Gfsm::StringAcceptor();
     _fsm->set_alphabet(init_alphabet());
     _fsm->ensure_root();
+    _compiled_stale = true;
+    _entry_count = 0;
 }
 
 void Lexicon::do_save_params() {
-    if (_fsm == nullptr)
+    if (!is_loaded())
         throw std::runtime_error("Tried to access uninitialized Lexicon");
+    if (_image != nullptr) {
+        // keep the format the lexicon was loaded in
+        if (!compiled()->dfa.is_valid())
+            optimize();
+        if (!_lexfile.empty())
+            save_image(_lexfile.string());
+        return;
+    }
     if (!_lexfile.empty())
         _fsm->save_binfile(_lexfile.string());
     if (!_symfile.empty())
         _fsm->get_alphabet().save_labfile(_symfile.string());
 }
 
+void Lexicon::load_image() {
+    auto image = std::make_shared<const LexiconImage>(_lexfile.string());
+    auto lex = std::make_shared<CompiledLexicon>();
+    lex->dfa = Gfsm::CompiledAcceptor(image->tables());
+    // the labels are indexed by this build's characters, which needn't
+    // be those of the build that wrote the image
+    for (size_t i = 0; i < image->symbols_size(); ++i) {
+        auto symbol = image->symbol(i);
+        lex->add_char_label(symbol.first, symbol.second);
+    }
+    lex->image = image;
+    _label_boundary = image->label_boundary();
+    _label_any      = image->label_any();
+    _label_epsilon  = image->label_epsilon();
+    // the automaton is only built if someone asks for it
+    delete _fsm;
+    _fsm = nullptr;
+    _image = image;
+    std::atomic_store(&_compiled,
+              std::shared_ptr<const CompiledLexicon>(std::move(lex)));
+    _compiled_stale = false;
+    _rebuild_after = image->tables().n_states + image->tables().n_arcs();
+    _fsm_lookups = 0;
+}
+
+void Lexicon::save_image(const std::string& fn) const {
+    auto lex = compiled();
+    if (!lex->dfa.is_valid())
+        throw std::runtime_error("Lexicon has to be deterministic to be "
+                                 "saved as an image, optimize it first");
+    LexiconImage::Contents c;
+    c.dfa = &lex->dfa;
+    if (lex->image != nullptr) {
+        for (size_t i = 0; i < lex->image->symbols_size(); ++i)
+            c.symbols.push_back(lex->image->symbol(i));
+    } else {
+        const Gfsm::Alphabet& alph = fsm()->get_alphabet();
+        for (const string_impl& symbol : alph.covered())
+            c.symbols.push_back(std::make_pair(symbol,
+                                               alph.get_label(symbol)));
+    }
+    c.label_boundary = _label_boundary;
+    c.label_any      = _label_any;
+    c.label_epsilon  = _label_epsilon;
+    LexiconImage::write(fn, c);
+}
+
 Gfsm::Alphabet Lexicon::init_alphabet() {
     Gfsm::Alphabet alph;
     if (boost::filesystem::exists(_symfile)) {
@@ -110,47 +175,309 @@ Gfsm::Alphabet Lexicon::init_alphabet() {
 }
 
 /********* ACCESS *********/
+Gfsm::StringAcceptor* Lexicon::fsm() const {
+    std::lock_guard<std::mutex> guard(_fsm_mutex);
+    if (_fsm == nullptr && _image != nullptr) {
+        Gfsm::Alphabet alph;
+        for (size_t i = 0; i < _image->symbols_size(); ++i) {
+            auto symbol = _image->symbol(i);
+            alph.add_mapping(symbol.first, symbol.second);
+        }
+        auto fsa = new Gfsm::StringAcceptor();
+        fsa->set_alphabet(alph);
+        Gfsm::CompiledAcceptor(_image->tables()).to_acceptor(fsa);
+        _fsm = fsa;
+    }
+    return _fsm;
+}
+
+void Lexicon::CompiledLexicon::add_char_label(const string_impl& symbol,
+                                              gfsmLabelVal label) {
+    if (symbol.length() == 1)
+        char_labels[symbol[0]] = label;
+}
+
+std::shared_ptr<const Lexicon::CompiledLexicon> Lexicon::compiled() const {
+    if (_compiled_stale) {
+        std::lock_guard<std::mutex> guard(_compile_mutex);
+        if (_compiled_stale) {
+            auto lex = std::make_shared<CompiledLexicon>();
+            const Gfsm::StringAcceptor* fsa = fsm();
+            lex->dfa = Gfsm::CompiledAcceptor(*fsa);
+            const Gfsm::Alphabet& alph = fsa->get_alphabet();
+            for (const string_impl& symbol : alph.covered())
+                lex->add_char_label(symbol, alph.get_label(symbol));
+            const Gfsm::CompiledAcceptor::Tables& t = lex->dfa.tables();
+            _rebuild_after = t.n_states + t.n_arcs();
+            _fsm_lookups = 0;
+            // lookups that are still running keep the old copy alive
+            std::atomic_store(&_compiled,
+                      std::shared_ptr<const CompiledLexicon>(std::move(lex)));
+            _compiled_stale = false;
+        }
+    }
+    return std::atomic_load(&_compiled);
+}
+
+std::shared_ptr<const Lexicon::CompiledLexicon> Lexicon::current() const {
+    // a rebuild costs about as much as the lookups it waits for, so
+    // adding words one at a time doesn't rebuild the table every time
+    if (_compiled_stale && _fsm_lookups++ < _rebuild_after)
+        return nullptr;
+    return compiled();
+}
+
+std::shared_ptr<const Gfsm::CompiledAcceptor>
+Lexicon::compiled_acceptor(std::vector<string_impl>* symbols) const {
+    if (!is_loaded())
+        throw std::runtime_error("Tried to access uninitialized Lexicon");
+    auto lex = compiled();
+    if (!lex->dfa.is_valid())
+        return nullptr;
+    if (symbols != nullptr)
+        *symbols = label_symbols(*lex);
+    // shares ownership with the whole compiled lexicon
+    return std::shared_ptr<const Gfsm::CompiledAcceptor>(lex, &lex->dfa);
+}
+
+gfsmStateId Lexicon::walk(const CompiledLexicon& lex,
+                          const string_impl& word) const {
+    return walk(lex, lex.dfa.root(), word);
+}
+
+gfsmStateId Lexicon::walk(const CompiledLexicon& lex, gfsmStateId state,
+                          const string_impl& word) const {
+    for (string_size i = 0; i < word.length(); ++i) {
+        gfsmLabelVal label = lex.char_labels.get(word[i]);
+        if (label == 0)
+            return gfsmNoState;
+        state = lex.dfa.step(state, label);
+        if (state == gfsmNoState)
+            return state;
+    }
+    return state;
+}
+
 bool Lexicon::check_contains(const string_impl& word) const {
-    if (_fsm == nullptr)
+    if (!is_loaded())
         throw std::runtime_error("Tried to access uninitialized Lexicon");
+    auto lex = current();
+    if (lex != nullptr && lex->dfa.is_valid()) {
+        gfsmStateId state = walk(*lex, word);
+        if (state == gfsmNoState)
+            return false;
+        return lex->dfa.is_final(lex->dfa.step(state, _label_boundary));
+    }
     std::vector<string_impl> vec;
     for (string_size i = 0; i < word.length(); ++i) {
         vec.push_back(from_char(word[i]));
     }
     vec.push_back(Lexicon::SYMBOL_BOUNDARY);
-    return _fsm->accepts(vec);
+    return fsm()->accepts(vec);
 }
 
 bool Lexicon::check_contains_partial(const string_impl& word) const {
-    if (_fsm == nullptr)
+    if (!is_loaded())
         throw std::runtime_error("Tried to access uninitialized Lexicon");
     if (word.length() == 0)
         return true;  // always accept empty word
-    return _fsm->accepts(word);
+    auto lex = current();
+    if (lex != nullptr && lex->dfa.is_valid())
+        return lex->dfa.is_final(walk(*lex, word));
+    return fsm()->accepts(word);
+}
+
+void Lexicon::init_cursor(Cursor* c) const {
+    if (!is_loaded())
+        throw std::runtime_error("Tried to access uninitialized Lexicon");
+    auto lex = current();
+    if (lex != nullptr && lex->dfa.is_valid()) {
+        c->state = lex->dfa.root();
+        // the table may be rebuilt while the cursor is used, and its
+        // states are only valid in the table they were taken from
+        c->snapshot = std::move(lex);
+    } else {
+        c->state = CURSOR_USES_PREFIX;
+    }
+}
+
+bool Lexicon::advance_cursor(Cursor* c, const string_impl& piece) const {
+    if (c->state == CURSOR_USES_PREFIX)
+        return LexiconInterface::advance_cursor(c, piece);
+    gfsmStateId state = walk(snapshot(*c), c->state, piece);
+    if (state == gfsmNoState)
+        return false;
+    c->state = state;
+    return true;
+}
+
+bool Lexicon::cursor_is_final(const Cursor& c) const {
+    if (c.state == CURSOR_USES_PREFIX)
+        return LexiconInterface::cursor_is_final(c);
+    const CompiledLexicon& lex = snapshot(c);
+    return lex.dfa.is_final(lex.dfa.step(c.state, _label_boundary));
 }
 
 bool Lexicon::add_word(const string_impl& word) {
-    if (_fsm == nullptr)
+    if (!is_loaded())
         throw std::runtime_error("Tried to access uninitialized Lexicon");
     if (check_contains(word))
         return false;
     std::vector<string_impl> vec;
+    bool multiword = false;
     for (string_size i = 0; i < word.length(); ++i) {
-        if (word[i] == ' ' || word[i] == '\t')
+        if (word[i] == ' ' || word[i] == '\t') {
             vec.push_back(Lexicon::SYMBOL_BOUNDARY);
-        else
+            multiword = true;
+        } else {
             vec.push_back(from_char(word[i]));
+        }
     }
     vec.push_back(Lexicon::SYMBOL_BOUNDARY);
-    _fsm->add_word(vec, true);
+    fsm()->add_word(vec, true);
+    _compiled_stale = true;
+    // every prefix of a multiword entry that ends in a boundary
+    // becomes an entry of its own, so those have to be counted again
+    if (!multiword && _entry_count >= 0)
+        ++_entry_count;
+    else
+        _entry_count = -1;
     return true;
 }
 
+void Lexicon::build(EntryIterator* words) {
+    clear();
+    Gfsm::Alphabet alph = _fsm->get_alphabet();
+    Gfsm::AcceptorBuilder builder;
+    std::vector<gfsmLabelVal> labels;
+    string_impl word;
+    int64_t count = 0;
+    bool multiword = false;
+    while (words->next(&word)) {
+        labels.clear();
+        for (string_size i = 0; i < word.length(); ++i) {
+            if (word[i] == ' ' || word[i] == '\t') {
+                labels.push_back(_label_boundary);
+                multiword = true;
+            } else {
+                labels.push_back(alph.add_symbol(from_char(word[i])));
+            }
+        }
+        labels.push_back(_label_boundary);
+        if (builder.add(labels, true))
+            ++count;
+    }
+    Gfsm::StringAcceptor* fsa = new Gfsm::StringAcceptor();
+    fsa->set_alphabet(alph);
+    builder.finish().to_acceptor(fsa);
+    delete _fsm;
+    _fsm = fsa;
+    _compiled_stale = true;
+    _entry_count = multiword ? -1 : count;
+}
+
+class Lexicon::DfaEntryIterator : public EntryIterator {
+ public:
+     DfaEntryIterator(std::shared_ptr<const CompiledLexicon> lex,
+                      std::vector<string_impl>&& symbols,
+                      gfsmLabelVal boundary)
+         : _lex(std::move(lex)), _symbols(std::move(symbols)),
+           _boundary(boundary) {
+         const Gfsm::CompiledAcceptor::Tables& t = _lex->dfa.tables();
+         if (t.root < t.n_states)
+             _stack.push_back(Frame { t.root, t.offsets[t.root] });
+     }
+
+     bool next(string_impl* word) {
+         const Gfsm::CompiledAcceptor::Tables& t = _lex->dfa.tables();
+         while (!_stack.empty()) {
+             Frame& top = _stack.back();
+             if (top.arc == t.offsets[top.state + 1]) {
+                 _stack.pop_back();
+                 if (!_path.empty())
+                     _path.pop_back();
+                 continue;
+             }
+             gfsmLabelVal label = t.labels[top.arc];
+             gfsmStateId target = t.targets[top.arc];
+             ++top.arc;
+             _path.push_back(label);
+             _stack.push_back(Frame { target, t.offsets[target] });
+             if (label == _boundary && t.finals[target]) {
+                 spell(word);
+                 return true;
+             }
+         }
+         return false;
+     }
+
+ private:
+     struct Frame {
+         gfsmStateId state;
+         uint32_t arc;  ///< next arc to follow
+     };
+
+     void spell(string_impl* word) const {
+         *word = string_impl();
+         for (gfsmLabelVal label : _path) {
+             if (label != _boundary && label < _symbols.size())
+                 *word += _symbols[label];
+         }
+     }
+
+     std::shared_ptr<const CompiledLexicon> _lex;
+     std::vector<string_impl> _symbols;
+     gfsmLabelVal _boundary;
+     std::vector<Frame> _stack;
+     std::vector<gfsmLabelVal> _path;
+};
+
+std::vector<string_impl>
+Lexicon::label_symbols(const CompiledLexicon& lex) const {
+    std::vector<string_impl> symbols;
+    auto set = [&symbols](const string_impl& symbol, gfsmLabelVal label) {
+        if (label >= symbols.size())
+            symbols.resize(label + 1);
+        symbols[label] = symbol;
+    };
+    if (lex.image != nullptr) {
+        for (size_t i = 0; i < lex.image->symbols_size(); ++i) {
+            auto symbol = lex.image->symbol(i);
+            set(symbol.first, symbol.second);
+        }
+    } else {
+        const Gfsm::Alphabet& alph = fsm()->get_alphabet();
+        for (const string_impl& symbol : alph.covered())
+            set(symbol, alph.get_label(symbol));
+    }
+    return symbols;
+}
+
+std::unique_ptr<LexiconInterface::EntryIterator>
+Lexicon::make_entry_iterator() const {
+    if (!is_loaded())
+        throw std::runtime_error("Tried to access uninitialized Lexicon");
+    auto lex = compiled();
+    if (!lex->dfa.is_valid())
+        return LexiconInterface::make_entry_iterator();
+    std::vector<string_impl> symbols = label_symbols(*lex);
+    return std::unique_ptr<EntryIterator>(
+        new DfaEntryIterator(std::move(lex), std::move(symbols),
+                             _label_boundary));
+}
+
 std::vector<string_impl> Lexicon::retrieve_all_entries() const {
     std::vector<string_impl> acc;
-    if (_fsm == nullptr)
+    if (!is_loaded())
+        return acc;
+    if (compiled()->dfa.is_valid()) {
+        auto entries = make_entry_iterator();
+        string_impl word;
+        while (entries->next(&word))
+            acc.push_back(word);
         return acc;
-    std::set<std::vector<string_impl>> a = _fsm->accepted_vectors();
+    }
+    std::set<std::vector<string_impl>> a = fsm()->accepted_vectors();
     for (const std::vector<string_impl>& v : a) {
         if (!v.empty() && v.back() == Lexicon::SYMBOL_BOUNDARY) {
             string_impl word;
@@ -165,28 +492,72 @@ std::vector<string_impl> Lexicon::retrieve_all_entries() const {
     return acc;
 }
 
+namespace {
+/// number of paths from state that end with a boundary in a final state
+uint64_t count_entries(const Gfsm::CompiledAcceptor::Tables& t,
+                       gfsmLabelVal boundary, gfsmStateId state,
+                       std::vector<uint64_t>* counts) {
+    const uint64_t unknown = static_cast<uint64_t>(-1);
+    if ((*counts)[state] != unknown)
+        return (*counts)[state];
+    uint64_t n = 0;
+    for (uint32_t arc = t.offsets[state]; arc < t.offsets[state + 1]; ++arc) {
+        if (t.labels[arc] == boundary && t.finals[t.targets[arc]])
+            ++n;
+        n += count_entries(t, boundary, t.targets[arc], counts);
+    }
+    (*counts)[state] = n;
+    return n;
+}
+}  // namespace
+
 unsigned int Lexicon::get_size() const {
-    // for now, we just get all entries and count them ...
-    // (this is cached by LexiconInterface)
-    return entries().size();
+    int64_t n = _entry_count;
+    if (n >= 0)
+        return n;
+    if (!is_loaded())
+        return 0;
+    auto lex = compiled();
+    if (lex->dfa.is_valid()) {
+        // shared suffixes are only counted once, no need to spell words
+        const Gfsm::CompiledAcceptor::Tables& t = lex->dfa.tables();
+        std::vector<uint64_t> counts(t.n_states, static_cast<uint64_t>(-1));
+        n = t.root < t.n_states
+            ? count_entries(t, _label_boundary, t.root, &counts) : 0;
+    } else {
+        n = entries().size();
+    }
+    _entry_count = n;
+    return n;
+}
+
+std::vector<std::string> Lexicon::get_param_files() const {
+    std::vector<std::string> files;
+    if (!_lexfile.empty())
+        files.push_back(_lexfile.string());
+    if (!_symfile.empty())
+        files.push_back(_symfile.string());
+    return files;
 }
 
 const Gfsm::Alphabet& Lexicon::get_alphabet() const {
-    if (_fsm == nullptr)
+    if (!is_loaded())
         throw std::runtime_error("Tried to access uninitialized Lexicon");
-    return _fsm->get_alphabet();
+    return fsm()->get_alphabet();
 }
 
 void Lexicon::optimize() {
-    if (_fsm == nullptr)
+    if (!is_loaded())
         throw std::runtime_error("Tried to access uninitialized Lexicon");
-    _fsm->arith_sr_zero_to_zero();
-    _fsm->arcsort();
-    _fsm->arcuniq();
-    _fsm->determinize();
+    Gfsm::StringAcceptor* fsa = fsm();
+    fsa->arith_sr_zero_to_zero();
+    fsa->arcsort();
+    fsa->arcuniq();
+    fsa->determinize();
     // epsilon removal shouldn't be required for lexicon FSTs,
     // and setting this to true makes the minimization take AGES:
-    _fsm->minimize(false);
+    fsa->minimize(false);
+    _compiled_stale = true;
 }
 
 }  // namespace Normalizer
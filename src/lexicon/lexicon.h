@@ -20,9 +20,14 @@
 #include<map>
 #include<string>
 #include<vector>
+#include<memory>
+#include<mutex>
+#include<atomic>
+#include<cstdint>
 #include<boost/filesystem.hpp>  // NOLINT[build/include_order]
 #include"gfsm_wrapper.h"
 #include"string_impl.h"
+#include"lexicon/lexicon_image.h"
 #include"lexicon/lexicon_interface.h"
 
 namespace Norma {
@@ -48,20 +53,98 @@ friend class Gfsm::StringCascade;
 
      /// perform (possibly time-intensive) FST optimizations
      void optimize();
+     /// replace the contents with words, which have to be sorted
+     /** Builds the minimal automaton in one pass, so optimize() isn't
+      *  needed afterwards. Words with a common prefix have to be grouped
+      *  together, as in any lexicographic order.
+      *  @throw std::invalid_argument if the words aren't sorted
+      **/
+     void build(EntryIterator* words);
+     /// save the lexicon as a memory-mappable image
+     /** The image can be used as fsmfile instead of a gfsm automaton, in
+      *  which case no symfile is needed. Requires a deterministic lexicon,
+      *  i.e., call optimize() first.
+      **/
+     void save_image(const std::string& fn) const;
 
      static const string_impl SYMBOL_BOUNDARY;
      static const string_impl SYMBOL_ANY;
      static const string_impl SYMBOL_EPSILON;
 
      const Gfsm::Alphabet& get_alphabet() const;
+     /// the compiled automaton, for searches that walk it directly
+     /** The acceptor stays valid as long as the pointer is kept, even if
+      *  the lexicon is changed in the meantime.
+      *  @param symbols if given, receives the symbols indexed by label
+      *  @return nullptr if the lexicon isn't deterministic
+      **/
+     std::shared_ptr<const Gfsm::CompiledAcceptor>
+     compiled_acceptor(std::vector<string_impl>* symbols = nullptr) const;
+     gfsmLabelVal get_boundary_label() const { return _label_boundary; }
 
  protected:
-     Gfsm::StringAcceptor* get_acceptor() const { return _fsm; }
+     Gfsm::StringAcceptor* get_acceptor() const { return fsm(); }
 
  private:
+     /// flat copy of _fsm for lookups without allocations
+     struct CompiledLexicon {
+         Gfsm::CompiledAcceptor dfa;
+         /// labels of the single character symbols
+         DenseCharMap<gfsmLabelVal> char_labels;
+         /// the image dfa points into, if any
+         std::shared_ptr<const LexiconImage> image;
+         void add_char_label(const string_impl& symbol, gfsmLabelVal label);
+     };
+
      boost::filesystem::path _lexfile;
      boost::filesystem::path _symfile;
-     Gfsm::StringAcceptor* _fsm = nullptr;
+     /// built from _image on first use if the lexicon was loaded from one
+     mutable Gfsm::StringAcceptor* _fsm = nullptr;
+     mutable std::mutex _fsm_mutex;
+     std::shared_ptr<const LexiconImage> _image;
+     Gfsm::StringAcceptor* fsm() const;
+     bool is_loaded() const { return _image != nullptr || _fsm != nullptr; }
+     void load_image();
+
+     /// compiled again some lookups after _fsm was changed
+     mutable std::shared_ptr<const CompiledLexicon> _compiled;
+     mutable std::atomic<bool> _compiled_stale{true};
+     mutable std::mutex _compile_mutex;
+     /// lookups answered by _fsm since _compiled went stale
+     mutable std::atomic<size_t> _fsm_lookups{0};
+     /// how many of those it takes before _compiled is rebuilt
+     mutable std::atomic<size_t> _rebuild_after{0};
+     std::shared_ptr<const CompiledLexicon> compiled() const;
+     /// _compiled if it's up to date or worth rebuilding now
+     /** @return nullptr if the lookup should use _fsm instead
+      */
+     std::shared_ptr<const CompiledLexicon> current() const;
+     /// follow the characters of word from the root
+     /** @return the state reached, or gfsmNoState
+      */
+     gfsmStateId walk(const CompiledLexicon& lex,
+                      const string_impl& word) const;
+     /// follow the characters of word from state
+     gfsmStateId walk(const CompiledLexicon& lex, gfsmStateId state,
+                      const string_impl& word) const;
+
+     /// Cursor::state for cursors that keep the prefix instead
+     static const size_t CURSOR_USES_PREFIX = static_cast<size_t>(-1);
+     void init_cursor(Cursor* c) const;
+     bool advance_cursor(Cursor* c, const string_impl& piece) const;
+     bool cursor_is_final(const Cursor& c) const;
+     /// the compiled lexicon a cursor was started on
+     static const CompiledLexicon& snapshot(const Cursor& c) {
+         return *static_cast<const CompiledLexicon*>(c.snapshot.get());
+     }
+
+     /// depth-first walk through the compiled lexicon
+     class DfaEntryIterator;
+     std::unique_ptr<EntryIterator> make_entry_iterator() const;
+     /// symbols of the alphabet, indexed by label
+     std::vector<string_impl> label_symbols(const CompiledLexicon& lex) const;
+     /// number of entries, or -1 if it has to be counted again
+     mutable std::atomic<int64_t> _entry_count{-1};
 
      gfsmLabelVal _label_boundary;
      gfsmLabelVal _label_any;
@@ -78,6 +161,7 @@ friend class Gfsm::StringCascade;
      bool add_word(const string_impl& word);
      std::vector<string_impl> retrieve_all_entries() const;
      unsigned int get_size() const;
+     std::vector<std::string> get_param_files() const;
 };
 
 }  // namespace Normalizer
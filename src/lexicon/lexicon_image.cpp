@@ -0,0 +1,258 @@
+/* Copyright 2013-2015 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include"lexicon_image.h"
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+#include<algorithm>
+#include<cstdio>
+#include<cstring>
+#include<fstream>
+#include<stdexcept>
+#include<string>
+#include<utility>
+#include<vector>
+#include"exceptions.h"
+
+namespace Norma {
+namespace Normalizer {
+
+namespace {
+const char MAGIC[8] = {'N', 'O', 'R', 'M', 'A', 'L', 'E', 'X'};
+const uint32_t ENDIAN_MARK = 0x01020304;
+
+uint64_t align(uint64_t offset) {
+    return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+}  // namespace
+
+static_assert(sizeof(gfsmLabelVal) == sizeof(uint32_t)
+              && sizeof(gfsmStateId) == sizeof(uint32_t),
+              "lexicon images store labels and states as 32 bit integers");
+
+/// at the start of the file, all offsets are from the start of the file
+struct LexiconImage::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t n_states, n_arcs, root, n_symbols;
+    uint32_t label_boundary, label_any, label_epsilon;
+    uint64_t offsets, labels, targets, finals, symbols, text;
+    uint64_t file_size;
+};
+
+/// an alphabet entry, the symbol is stored as UTF-8 in the text section
+struct LexiconImage::Symbol {
+    uint32_t label, offset, length;
+};
+
+LexiconImage::LexiconImage(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw init_error("couldn't open lexicon image: " + filename);
+    struct stat st;
+    if (fstat(fd, &st) != 0
+        || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        close(fd);
+        throw init_error("not a lexicon image: " + filename);
+    }
+    _size = st.st_size;
+    void* data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        throw init_error("couldn't map lexicon image: " + filename);
+    _data = static_cast<const char*>(data);
+
+    const Header* h = header();
+    std::string error;
+    if (memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0)
+        error = "not a lexicon image: ";
+    else if (h->byte_order != ENDIAN_MARK)
+        error = "lexicon image was written with a different byte order: ";
+    else if (h->version != VERSION)
+        error = "lexicon image has an unsupported version: ";
+    else if (h->file_size != _size)
+        error = "lexicon image is truncated: ";
+    else if (!is_consistent())
+        error = "lexicon image is corrupt: ";
+    if (!error.empty()) {
+        munmap(const_cast<char*>(_data), _size);
+        throw init_error(error + filename);
+    }
+}
+
+bool LexiconImage::is_consistent() const {
+    const Header* h = header();
+    const uint64_t n_states = h->n_states, n_arcs = h->n_arcs;
+    // count is at most 2^32 and size small, so this can't overflow
+    auto fits = [this](uint64_t offset, uint64_t count, uint64_t size) {
+        return offset == align(offset) && offset <= _size
+               && count * size <= _size - offset;
+    };
+    if (!fits(h->offsets, n_states + 1, sizeof(uint32_t))
+        || !fits(h->labels, n_arcs, sizeof(gfsmLabelVal))
+        || !fits(h->targets, n_arcs, sizeof(gfsmStateId))
+        || !fits(h->finals, n_states, sizeof(char))
+        || !fits(h->symbols, h->n_symbols, sizeof(Symbol))
+        || !fits(h->text, 0, 1))
+        return false;
+    const Symbol* symbols = section<Symbol>(h->symbols);
+    const uint64_t text_size = _size - h->text;
+    gfsmLabelVal max_label = 0;
+    for (uint32_t i = 0; i < h->n_symbols; ++i) {
+        if (static_cast<uint64_t>(symbols[i].offset) + symbols[i].length
+            > text_size)
+            return false;
+        max_label = std::max(max_label, symbols[i].label);
+    }
+    if (h->label_boundary > max_label || h->label_any > max_label
+        || h->label_epsilon > max_label)
+        return false;
+    // lookups follow the arcs without checking them again
+    const uint32_t* offsets = section<uint32_t>(h->offsets);
+    const gfsmLabelVal* labels = section<gfsmLabelVal>(h->labels);
+    const gfsmStateId* targets = section<gfsmStateId>(h->targets);
+    if (n_states > 0 && h->root >= n_states)
+        return false;
+    if (offsets[0] != 0 || offsets[n_states] != n_arcs)
+        return false;
+    for (uint64_t state = 0; state < n_states; ++state) {
+        if (offsets[state] > offsets[state + 1])
+            return false;
+    }
+    for (uint64_t arc = 0; arc < n_arcs; ++arc) {
+        if (targets[arc] >= n_states || labels[arc] > max_label)
+            return false;
+    }
+    return true;
+}
+
+LexiconImage::~LexiconImage() {
+    if (_data != nullptr)
+        munmap(const_cast<char*>(_data), _size);
+}
+
+bool LexiconImage::is_image(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    if (!file.read(magic, sizeof(magic)))
+        return false;
+    return memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+void LexiconImage::write(const std::string& filename, const Contents& c) {
+    const Gfsm::CompiledAcceptor::Tables& t = c.dfa->tables();
+    std::vector<Symbol> symbols;
+    std::string text;
+    for (const auto& symbol : c.symbols) {
+        std::string utf8 = to_utf8(symbol.first);
+        symbols.push_back(Symbol { symbol.second,
+                                   static_cast<uint32_t>(text.size()),
+                                   static_cast<uint32_t>(utf8.size()) });
+        text += utf8;
+    }
+
+    Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version        = VERSION;
+    h.byte_order     = ENDIAN_MARK;
+    h.n_states       = t.n_states;
+    h.n_arcs         = t.n_arcs();
+    h.root           = t.root;
+    h.n_symbols      = symbols.size();
+    h.label_boundary = c.label_boundary;
+    h.label_any      = c.label_any;
+    h.label_epsilon  = c.label_epsilon;
+    h.offsets = align(sizeof(Header));
+    h.labels  = align(h.offsets + (h.n_states + 1) * sizeof(uint32_t));
+    h.targets = align(h.labels + h.n_arcs * sizeof(gfsmLabelVal));
+    h.finals  = align(h.targets + h.n_arcs * sizeof(gfsmStateId));
+    h.symbols = align(h.finals + h.n_states);
+    h.text    = align(h.symbols + h.n_symbols * sizeof(Symbol));
+    h.file_size = h.text + text.size();
+
+    // the old file may still be mapped, so it must not be overwritten
+    // in place; write a new one and move it over the old one instead
+    std::string tmpname = filename + ".tmp";
+    std::ofstream file(tmpname, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        throw std::runtime_error("couldn't open file for writing: "
+                                 + tmpname);
+    uint64_t pos = 0;
+    auto put = [&file, &pos](uint64_t offset, const void* data, size_t len) {
+        static const char padding[8] = {0};
+        file.write(padding, offset - pos);
+        file.write(static_cast<const char*>(data), len);
+        pos = offset + len;
+    };
+    const uint32_t no_offsets[1] = {0};
+    put(0, &h, sizeof(h));
+    put(h.offsets, t.n_states > 0 ? t.offsets : no_offsets,
+        (h.n_states + 1) * sizeof(uint32_t));
+    put(h.labels, t.labels, h.n_arcs * sizeof(gfsmLabelVal));
+    put(h.targets, t.targets, h.n_arcs * sizeof(gfsmStateId));
+    put(h.finals, t.finals, h.n_states);
+    put(h.symbols, symbols.data(), h.n_symbols * sizeof(Symbol));
+    put(h.text, text.data(), text.size());
+    file.close();
+    if (!file || std::rename(tmpname.c_str(), filename.c_str()) != 0) {
+        std::remove(tmpname.c_str());
+        throw std::runtime_error("error writing lexicon image: " + filename);
+    }
+}
+
+Gfsm::CompiledAcceptor::Tables LexiconImage::tables() const {
+    const Header* h = header();
+    Gfsm::CompiledAcceptor::Tables t;
+    t.n_states = h->n_states;
+    t.root = h->root;
+    if (h->n_states > 0) {
+        t.offsets = section<uint32_t>(h->offsets);
+        t.labels  = section<gfsmLabelVal>(h->labels);
+        t.targets = section<gfsmStateId>(h->targets);
+        t.finals  = section<char>(h->finals);
+    }
+    return t;
+}
+
+size_t LexiconImage::symbols_size() const {
+    return header()->n_symbols;
+}
+
+std::pair<string_impl, gfsmLabelVal> LexiconImage::symbol(size_t i) const {
+    const Symbol& s = section<Symbol>(header()->symbols)[i];
+    const char* text = section<char>(header()->text) + s.offset;
+    return std::make_pair(from_utf8(text, s.length), s.label);
+}
+
+gfsmLabelVal LexiconImage::label_boundary() const {
+    return header()->label_boundary;
+}
+
+gfsmLabelVal LexiconImage::label_any() const {
+    return header()->label_any;
+}
+
+gfsmLabelVal LexiconImage::label_epsilon() const {
+    return header()->label_epsilon;
+}
+
+}  // namespace Normalizer
+}  // namespace Norma
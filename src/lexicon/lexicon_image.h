@@ -0,0 +1,93 @@
+/* Copyright 2013-2015 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef NORMALIZER_LEXICON_IMAGE_H_
+#define NORMALIZER_LEXICON_IMAGE_H_
+#include<cstdint>
+#include<string>
+#include<utility>
+#include<vector>
+#include"gfsmlibs.h"
+#include"gfsm/compiled_acceptor.h"
+#include"string_impl.h"
+
+namespace Norma {
+namespace Normalizer {
+
+/// A lexicon in a binary format that can be mapped into memory.
+/** The file holds the compiled lexicon automaton and its alphabet. It
+ *  only uses offsets, never pointers, so it can be used right where it
+ *  is mapped, without parsing anything. The mapping is read-only and
+ *  shared, so all processes using the same image share its pages.
+ *  Symbols are stored as UTF-8, so builds with any string
+ *  implementation can use the same image.
+ *
+ *  The format is versioned, and files written by a different version or
+ *  on a machine with a different byte order are rejected.
+ **/
+class LexiconImage {
+ public:
+     /// everything needed to write an image
+     struct Contents {
+         const Gfsm::CompiledAcceptor* dfa;
+         std::vector<std::pair<string_impl, gfsmLabelVal>> symbols;
+         gfsmLabelVal label_boundary, label_any, label_epsilon;
+     };
+
+     /// map an image file, throws init_error if it's not a valid image
+     explicit LexiconImage(const std::string& filename);
+     LexiconImage(const LexiconImage& a) = delete;
+     const LexiconImage& operator=(const LexiconImage& a) = delete;
+     ~LexiconImage();
+
+     /// check if a file starts like an image
+     static bool is_image(const std::string& filename);
+     /// write an image file
+     static void write(const std::string& filename, const Contents& c);
+
+     /// the transition tables, pointing into the mapped file
+     Gfsm::CompiledAcceptor::Tables tables() const;
+     size_t symbols_size() const;
+     /// symbol and label of the i-th entry of the alphabet
+     std::pair<string_impl, gfsmLabelVal> symbol(size_t i) const;
+     gfsmLabelVal label_boundary() const;
+     gfsmLabelVal label_any() const;
+     gfsmLabelVal label_epsilon() const;
+
+     static const uint32_t VERSION = 2;
+
+ private:
+     struct Header;
+     struct Symbol;
+     /// check that all sections and symbols lie inside the file, and
+     /// that the automaton only uses its own states and labels
+     bool is_consistent() const;
+     const Header* header() const {
+         return reinterpret_cast<const Header*>(_data);
+     }
+     template<typename T> const T* section(uint64_t offset) const {
+         return reinterpret_cast<const T*>(_data + offset);
+     }
+
+     const char* _data = nullptr;
+     size_t _size = 0;
+};
+
+}  // namespace Normalizer
+}  // namespace Norma
+
+#endif  // NORMALIZER_LEXICON_IMAGE_H_
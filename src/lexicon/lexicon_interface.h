@@ -17,8 +17,12 @@
  */
 #ifndef NORMALIZER_LEXICON_INTERFACE_H_
 #define NORMALIZER_LEXICON_INTERFACE_H_
+#include<cstddef>
+#include<cstdint>
 #include<map>
+#include<memory>
 #include<string>
+#include<utility>
 #include<vector>
 #include"string_impl.h"
 
@@ -27,18 +31,70 @@ namespace Normalizer {
 
 class LexiconInterface {
  public:
+     /// a position in the lexicon, reached by reading a prefix
+     /** A Cursor starts at the empty prefix and can be extended
+      *  piece by piece, so searches that build up words don't have
+      *  to look up the whole prefix again for every extension.
+      *  Cursors are cheap to copy. Words added to the lexicon while a
+      *  cursor is in use may or may not be seen by it.
+      **/
+     class Cursor {
+      public:
+         Cursor() = default;
+         /// read piece; returns true if the prefix is still in the lexicon
+         bool advance(const string_impl& piece) {
+             if (_valid)
+                 _valid = _lex->advance_cursor(this, piece);
+             return _valid;
+         }
+         /// true if the prefix read so far is part of a lexicon entry
+         bool is_valid() const { return _valid; }
+         /// true if the prefix read so far is a lexicon entry
+         bool is_final() const {
+             return _valid && _lex->cursor_is_final(*this);
+         }
+
+         // the following are for the lexicon implementation to use:
+         /// implementation specific state, e.g. a state of an automaton
+         size_t state = 0;
+         /// keeps alive what state refers to, e.g. the automaton
+         std::shared_ptr<const void> snapshot;
+         /// prefix read so far, only kept if the implementation needs it
+         string_impl prefix;
+
+      private:
+         friend class LexiconInterface;
+         const LexiconInterface* _lex = nullptr;
+         bool _valid = false;
+     };
+
+     /// yields the lexicon entries one at a time
+     /** Iterators must not be used anymore once the lexicon was changed.
+      **/
+     class EntryIterator {
+      public:
+         virtual ~EntryIterator() {}
+         /// get the next entry, returns false if there are no more
+         virtual bool next(string_impl* word) = 0;
+     };
+     /// yields the words from a vector
+     class VectorEntryIterator;
+
      virtual ~LexiconInterface() {}
 
      // avoid public virtual functions
      // I'm blindly following <http://www.gotw.ca/publications/mill18.htm> here
      void init() {
+         ++_revision;
          do_init();
      }
      void init(const std::map<std::string, std::string>& params) {
+         ++_revision;
          do_set_from_params(params);
          do_init();
      }
      void clear() {
+         ++_revision;
          _entries_cache_initialized = false;
          _entries_cache.clear();
          do_clear();
@@ -57,9 +113,16 @@ class LexiconInterface {
      }
      void add(const string_impl& word) {
          bool added = add_word(word);
+         if (added)
+             ++_revision;
          if (added && _entries_cache_initialized)
              _entries_cache.push_back(word);
      }
+     /// changes whenever entries are added or removed
+     /** Normalizers can compare this to tell whether the lexicon was
+      *  changed since they last looked.
+      **/
+     uint64_t revision() const { return _revision; }
      std::vector<string_impl> entries() const {
          if (!_entries_cache_initialized) {
              _entries_cache = retrieve_all_entries();
@@ -70,10 +133,39 @@ class LexiconInterface {
      unsigned int size() const {
          return get_size();
      }
+     /// files the lexicon was loaded from
+     std::vector<std::string> param_files() const {
+         return get_param_files();
+     }
+     /// iterate over the entries without collecting them first
+     std::unique_ptr<EntryIterator> entry_iterator() const {
+         return make_entry_iterator();
+     }
+     /// a Cursor at the empty prefix
+     Cursor cursor() const {
+         Cursor c;
+         c._lex = this;
+         c._valid = true;
+         init_cursor(&c);
+         return c;
+     }
 
  protected:
      LexiconInterface() = default;
 
+     // the cursor functions fall back to looking up the whole prefix.
+     // implementations should override them if they can do better.
+     virtual void init_cursor(Cursor* c) const {}
+     virtual bool advance_cursor(Cursor* c, const string_impl& piece) const {
+         c->prefix += piece;
+         return check_contains_partial(c->prefix);
+     }
+     virtual bool cursor_is_final(const Cursor& c) const {
+         return check_contains(c.prefix);
+     }
+     /// falls back to iterating over entries()
+     virtual std::unique_ptr<EntryIterator> make_entry_iterator() const;
+
  private:
      virtual void do_init() = 0;
      virtual void do_clear() = 0;
@@ -85,11 +177,34 @@ class LexiconInterface {
      virtual bool add_word(const string_impl& word) = 0;
      virtual std::vector<string_impl> retrieve_all_entries() const = 0;
      virtual unsigned int get_size() const = 0;
+     virtual std::vector<std::string> get_param_files() const { return {}; }
 
      mutable std::vector<string_impl> _entries_cache;
      mutable bool _entries_cache_initialized = false;
+     uint64_t _revision = 0;
 };
 
+class LexiconInterface::VectorEntryIterator : public EntryIterator {
+ public:
+     explicit VectorEntryIterator(std::vector<string_impl> words)
+         : _words(std::move(words)) {}
+     bool next(string_impl* word) {
+         if (_pos == _words.size())
+             return false;
+         *word = _words[_pos++];
+         return true;
+     }
+
+ private:
+     std::vector<string_impl> _words;
+     size_t _pos = 0;
+};
+
+inline std::unique_ptr<LexiconInterface::EntryIterator>
+LexiconInterface::make_entry_iterator() const {
+    return std::unique_ptr<EntryIterator>(new VectorEntryIterator(entries()));
+}
+
 }  // namespace Normalizer
 }  // namespace Norma
 
@@ -29,6 +29,26 @@ namespace cfg = boost::program_options;
 
 void check_if_file_exists(const std::string& name, bool status);
 
+/// reads the first word of each line of a words file
+class WordFileReader
+    : public Norma::Normalizer::LexiconInterface::EntryIterator {
+ public:
+     explicit WordFileReader(const std::string& filename)
+         : _file(filename) {}
+     bool next(string_impl* word) {
+         std::string line;
+         if (!getline(_file, line) || _file.eof())
+             return false;
+         std::istringstream iss(line);
+         *word = string_impl();
+         iss >> *word;
+         return true;
+     }
+
+ private:
+     std::ifstream _file;
+};
+
 int main(int argc, char* argv[]) {
     cfg::options_description desc("Options");
     desc.add_options()
@@ -37,14 +57,22 @@ int main(int argc, char* argv[]) {
          "File containing a lexicon FST in binary format.")
         ("labels,l", cfg::value<std::string>()->required(),
          "File containing labels for the given lexicon FST.")
-        ("words,w", cfg::value<std::string>()->required(),
+        ("words,w", cfg::value<std::string>(),
          "File containing one lexicon entry per line in plain text format.")
+        ("image,i", cfg::value<std::string>(),
+         "File for a memory-mappable image of the lexicon, which can be "
+         "used as Lexicon.fsmfile without a symbol file and loads without "
+         "parsing. Written by --compile (if given) and --make-image.")
         ("compile,c", cfg::bool_switch()->default_value(false),
          "Generate the lexicon FST and a labels file from the entries "
-         "in the (plain text) words file.")
+         "in the (plain text) words file. This is a lot faster if the "
+         "words file is sorted (e.g., with `LC_ALL=C sort`).")
         ("extract,x", cfg::bool_switch()->default_value(false),
          "Write all lexicon entries in the lexicon FST with the associated "
          "labels file to the words file (in plain text).")
+        ("make-image,b", cfg::bool_switch()->default_value(false),
+         "Convert the lexicon FST with the associated labels file "
+         "to an image file.")
         ("no-optimize,n", cfg::bool_switch()->default_value(false),
          "When using --compile, don't perform additional optimizations "
          "on the FST. This will result in larger file sizes. Use this switch "
@@ -67,10 +95,15 @@ int main(int argc, char* argv[]) {
             return 0;
         }
         cfg::notify(m);
-        if (m["compile"].as<bool>() == m["extract"].as<bool>()) {
-            throw cfg::error("Need exactly one of --compile/-c "
-                             "or --extract/-x.");
+        if (m["compile"].as<bool>() + m["extract"].as<bool>()
+            + m["make-image"].as<bool>() != 1) {
+            throw cfg::error("Need exactly one of --compile/-c, "
+                             "--extract/-x or --make-image/-b.");
         }
+        if (!m["make-image"].as<bool>() && !m.count("words"))
+            throw cfg::error("--words/-w is required.");
+        if (m["make-image"].as<bool>() && !m.count("image"))
+            throw cfg::error("--image/-i is required.");
     }
     catch(cfg::error e) {
         std::cerr << "Error parsing command-line options: "
@@ -95,26 +128,39 @@ int main(int argc, char* argv[]) {
             try {
                 lex.init();
             } catch(Norma::Normalizer::init_error e) {}  // this is expected
-            std::ifstream file;
-            file.open(m["words"].as<std::string>(), std::ios::in);
-            // read words
-            std::cout << "Reading words and creating FST..." << std::endl;
-            std::string line = "";
-            while (getline(file, line)) {
-                if (file.eof())
-                    break;
-                std::istringstream iss(line);
+            // a sorted words file gives the minimized FST in one pass,
+            // this only works when starting from scratch
+            bool built = false;
+            if (!boost::filesystem::exists(m["automaton"].as<std::string>())) {
+                std::cout << "Reading words and building minimized FST..."
+                          << std::endl;
+                WordFileReader words(m["words"].as<std::string>());
+                try {
+                    lex.build(&words);
+                    built = true;
+                } catch(const std::invalid_argument& e) {
+                    std::cout << "Words file is not sorted, adding words "
+                              << "one at a time instead..." << std::endl;
+                    lex.clear();
+                }
+            }
+            if (!built) {
+                std::cout << "Reading words and creating FST..." << std::endl;
+                WordFileReader words(m["words"].as<std::string>());
                 string_impl word;
-                iss >> word;
-                lex.add(word);
+                while (words.next(&word))
+                    lex.add(word);
             }
-            file.close();
-            if (!m["no-optimize"].as<bool>()) {
+            if (!built && !m["no-optimize"].as<bool>()) {
                 std::cout << "Optimizing FST..." << std::endl;
                 lex.optimize();
             }
             std::cout << "Saving..." << std::endl;
             lex.save_params();
+            if (m.count("image")) {
+                std::cout << "Saving image..." << std::endl;
+                lex.save_image(m["image"].as<std::string>());
+            }
         // ###################### EXTRACT ######################
         } else if (m["extract"].as<bool>()) {
             // check files
@@ -129,13 +175,25 @@ int main(int argc, char* argv[]) {
             lex.set_lexfile(m["automaton"].as<std::string>());
             lex.set_symfile(m["labels"].as<std::string>());
             lex.init();
-            auto entries = lex.entries();
-            // write to file
+            // write to file, one entry at a time
             std::cout << "Writing to words file..." << std::endl;
-            for (auto entry : entries) {
-                file << entry << std::endl;
+            auto entries = lex.entry_iterator();
+            string_impl entry;
+            while (entries->next(&entry)) {
+                file << entry << '\n';
             }
             file.close();
+        // ##################### MAKE IMAGE ####################
+        } else if (m["make-image"].as<bool>()) {
+            if (!m["force"].as<bool>())
+                check_if_file_exists(m["image"].as<std::string>(), false);
+            std::cout << "Opening lexicon FST..." << std::endl;
+            Norma::Normalizer::Lexicon lex;
+            lex.set_lexfile(m["automaton"].as<std::string>());
+            lex.set_symfile(m["labels"].as<std::string>());
+            lex.init();
+            std::cout << "Saving image..." << std::endl;
+            lex.save_image(m["image"].as<std::string>());
         }
         std::cout << "Done." << std::endl;
         // #####################################################
@@ -21,6 +21,7 @@
 #include<map>
 #include<vector>
 #include<stdexcept>
+#include<chrono>
 #include<boost/program_options.hpp>  //NOLINT[build/include_order]
 #include<boost/filesystem.hpp>       //NOLINT[build/include_order]
 #include"config.h"
@@ -48,6 +49,14 @@ int main(int argc, char* argv[]) {
          "Has no effect when not using the '-f' option.")
         ("sync,s", cfg::bool_switch()->default_value(false),
          "Run synchronously (don't start multiple threads).")
+        ("threads", cfg::value<unsigned>()->default_value(0),
+         "Number of worker threads used for normalization.  "
+         "Default value: 0 (one per hardware thread)")
+        ("flush-interval", cfg::value<unsigned>()->default_value(0),
+         "Write buffered output at least every N milliseconds, "
+         "for use in pipes.  "
+         "Default value: 0 (only when the buffer is full, "
+         "and at the end of input)")
         ("plugin-base,P",
          cfg::value<std::string>()->default_value(NORMA_DEFAULT_PLUGIN_BASE),
          "Base directory for the normalizer plugins."
@@ -61,6 +70,28 @@ int main(int argc, char* argv[]) {
          "Save normalizer parameter files when exiting.  Without this option, "
          "changes resulting from normalizer training only have an effect "
          "during the current session and are discarded afterwards.")
+        ("dedup", cfg::bool_switch()->default_value(false),
+         "Read the whole input first and normalize every distinct wordform "
+         "only once, then write the results in the original order.  "
+         "Training pairs in the input are all used before normalizing.")
+        ("batch-train", cfg::bool_switch()->default_value(false),
+         "Collect all training pairs in the input and train on them once "
+         "at the end of input, instead of after every pair.  "
+         "Always on with --train.")
+        ("cache-size", cfg::value<unsigned>()->default_value(0),
+         "Cache the final normalization of up to N distinct wordforms for "
+         "the whole normalizer chain, so repeated wordforms don't go "
+         "through the chain again.  The cache is emptied whenever the "
+         "chain is trained.  "
+         "Default value: 0 (no cache)")
+        ("disk-cache", cfg::value<std::string>(),
+         "Keep normalization results in this file, to be reused by later "
+         "runs with the same normalizer parameters.  Several processes can "
+         "use the same file at once.  It is not used after the chain has "
+         "been trained on any pair.")
+        ("disk-cache-size", cfg::value<unsigned>()->default_value(256),
+         "Maximum size of the disk cache file in MiB.  "
+         "Default value: 256")
         ("normalizers", cfg::value<std::string>(),
          "Normalizer chain as a comma-separated list")
         ;  //NOLINT[whitespace/semicolon]
@@ -129,7 +160,13 @@ int main(int argc, char* argv[]) {
 
     try {
         if (m.count("file")) {
-            input = new Norma::FileInput(m["file"].as<std::string>());
+            // regular files are mapped into memory, anything
+            // else (e.g. named pipes) is read as a stream
+            const std::string& fname = m["file"].as<std::string>();
+            if (boost::filesystem::is_regular_file(fname))
+                input = new Norma::MappedFileInput(fname);
+            else
+                input = new Norma::FileInput(fname);
             if (m["perfilemode"].as<bool>())
                 file_opts["perfilemode.input"] = m["file"].as<std::string>();
         } else {
@@ -138,15 +175,30 @@ int main(int argc, char* argv[]) {
             return 1;
         }
         output = new Norma::Output();
+        output->set_flush_interval(std::chrono::milliseconds(
+            m["flush-interval"].as<unsigned>()));
         Norma::Cycle c;
         c.init(input, output, file_opts);
         c.init_chain(m["normalizers"].as<std::string>(),
                      m["plugin-base"].as<std::string>());
         if (m["sync"].as<bool>())
             c.set_thread(false);
+        c.set_threads(m["threads"].as<unsigned>());
+        c.set_cache_size(m["cache-size"].as<unsigned>());
+        if (m.count("disk-cache"))
+            c.set_disk_cache(m["disk-cache"].as<std::string>(),
+                static_cast<size_t>(m["disk-cache-size"].as<unsigned>()) << 20);
         // v-- this doesn't work for some reason
-        if (m["train"].as<bool>())
+        // nothing is normalized in between, so all training pairs
+        // can be collected first and trained on in one go
+        if (m["train"].as<bool>()) {
             c.set("normalize", false);
+            c.set("batchtrain", true);
+        }
+        if (m["dedup"].as<bool>())
+            c.set("dedup", true);
+        if (m["batch-train"].as<bool>())
+            c.set("batchtrain", true);
         c.start();
         if (m["saveonexit"].as<bool>())
             c.save_params();
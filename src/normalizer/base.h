@@ -20,11 +20,14 @@
 #include<list>
 #include<map>
 #include<string>
+#include<vector>
 #include<mutex>
 #include<shared_mutex>
 #include<boost/filesystem.hpp>  // NOLINT[build/include_order]
 #include"string_impl.h"
+#include"cacheable.h"
 #include"result.h"
+#include"symbol_table.h"
 #include"training_data.h"
 
 namespace Norma {
@@ -83,16 +86,38 @@ class Base {
          std::shared_lock<std::shared_timed_mutex> read_lock(_mutex);
          return do_normalize(word);
      }
+     /// Normalize a word that was already interned
+     /** symbols must be the result of SymbolTable::global().intern(word);
+      *  PluginSocket does this once per word for the whole chain.
+      **/
+     Result operator()(const string_impl& word,
+                       const SymbolString& symbols) const {
+         std::shared_lock<std::shared_timed_mutex> read_lock(_mutex);
+         return do_normalize(word, symbols);
+     }
      /// Normalize to N best results
      ResultSet operator()(const string_impl& word, unsigned int n) const {
          std::shared_lock<std::shared_timed_mutex> read_lock(_mutex);
          return do_normalize(word, n);
      }
+     /// Words whose results may have changed by the last call to train()
+     /** Callers can use this to keep cached results of all other
+      *  words, see Cacheable::invalidate_cache().
+      **/
+     WordFilter affected_by_training() const {
+         std::shared_lock<std::shared_timed_mutex> read_lock(_mutex);
+         return do_affected_by_training();
+     }
      /// Save parameters to file(s)
      void save_params() {
          std::unique_lock<std::shared_timed_mutex> write_lock(_mutex);
          do_save_params();
      }
+     /// Files whose contents determine the results of this normalizer
+     /** These are hashed to tell whether stored results are still
+      *  valid, see PluginSocket::fingerprint().
+      **/
+     virtual std::vector<std::string> param_files() const { return {}; }
      /// This must return a name which is used as a namespace for params
      const std::string& name() const { return _name; }
      void set_name(const std::string& n) { _name = n; }
@@ -106,6 +131,19 @@ class Base {
      virtual ResultSet do_normalize(const string_impl& word,
                                      unsigned int n) const = 0;
      virtual void do_save_params() = 0;
+     // normalizers that can work on interned symbols may override
+     // this, the default ignores them
+     virtual Result do_normalize(const string_impl& word,
+                                 const SymbolString& /*symbols*/) const {
+         return do_normalize(word);
+     }
+     // normalizers that know which words a training step changed
+     // should override this, the default is all of them.  the filter
+     // is used without holding the lock, so it must not refer to
+     // members that change when training.
+     virtual WordFilter do_affected_by_training() const {
+         return [](const string_impl&) { return true; };
+     }
 
      // the following are convenience methods
      void log_message(Result* result,
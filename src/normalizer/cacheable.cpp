@@ -16,14 +16,169 @@
  * with Norma.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include"cacheable.h"
-#include<shared_mutex>
+#include<algorithm>
+#include<cstdint>
+#include<functional>
+#include<list>
+#include<map>
 #include<mutex>
-#include<atomic>
+#include<sstream>
+#include<string>
+#include<unordered_map>
+#include<utility>
+#include<vector>
 #include"normalizer/result.h"
 #include"string_impl.h"
 
 namespace Norma {
 namespace Normalizer {
+namespace {
+uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+size_t word_hash(const string_impl& word) {
+    uint64_t h = 14695981039346656037ULL;
+    for (string_size i = 0; i < word.length(); ++i) {
+        h ^= static_cast<uint64_t>(word[i]);
+        h *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(mix(h));
+}
+
+struct WordHash {
+    size_t operator()(const string_impl& word) const {
+        return word_hash(word);
+    }
+};
+
+struct WordEqual {
+    bool operator()(const string_impl& a, const string_impl& b) const {
+        return a == b;
+    }
+};
+
+/// Approximate recent lookup counts of words.
+/** A count-min sketch with four rows of 4-bit counters.  All counters
+ *  are halved after 10 lookups per cached entry, so words that were
+ *  frequent a long time ago lose their advantage.
+ **/
+class FrequencySketch {
+ public:
+     void reset(size_t capacity) {
+         size_t width = 64;
+         while (width < 4 * capacity && width < MAX_WIDTH)
+             width <<= 1;
+         _counters.assign(width, 0);
+         _mask = width - 1;
+         _sample = 10 * std::max<size_t>(capacity, 16);
+         _additions = 0;
+     }
+     void clear() {
+         std::fill(_counters.begin(), _counters.end(), 0);
+         _additions = 0;
+     }
+     void record(size_t hash) {
+         for (unsigned int row = 0; row < ROWS; ++row) {
+             uint8_t& counter = _counters[index(hash, row)];
+             if (counter < MAX_COUNT)
+                 ++counter;
+         }
+         if (++_additions >= _sample)
+             age();
+     }
+     unsigned int estimate(size_t hash) const {
+         unsigned int count = MAX_COUNT;
+         for (unsigned int row = 0; row < ROWS; ++row)
+             count = std::min<unsigned int>(count,
+                                            _counters[index(hash, row)]);
+         return count;
+     }
+
+ private:
+     static const unsigned int ROWS = 4;
+     static const uint8_t MAX_COUNT = 15;
+     static const size_t MAX_WIDTH = 1 << 22;
+     std::vector<uint8_t> _counters;
+     size_t _mask = 0;
+     size_t _sample = 0;
+     size_t _additions = 0;
+
+     size_t index(size_t hash, unsigned int row) const {
+         static const uint64_t seeds[ROWS] = {
+             0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL,
+             0x165667b19e3779f9ULL, 0x27d4eb2f165667c5ULL };
+         return static_cast<size_t>(mix(hash * seeds[row])) & _mask;
+     }
+     void age() {
+         for (auto& counter : _counters)
+             counter >>= 1;
+         _additions = 0;
+     }
+};
+
+size_t shard_capacity(size_t size, size_t shards) {
+    return (size + shards - 1) / shards;
+}
+}  // namespace
+
+const size_t Cacheable::DEFAULT_CACHE_SIZE;
+const size_t Cacheable::SHARDS;
+
+struct Cacheable::Shard {
+    struct Entry {
+        Entry(const string_impl& w, const Result& r, uint64_t v)
+            : word(w), result(r), version(v) {}
+        string_impl word;
+        Result result;
+        uint64_t version;
+    };
+    typedef std::list<Entry> EntryList;
+    // keys point to the words in lru, so each word is only stored once
+    typedef std::unordered_map<std::reference_wrapper<const string_impl>,
+                               EntryList::iterator,
+                               WordHash, WordEqual> EntryIndex;
+
+    std::mutex mutex;
+    /// most recently used entry first
+    EntryList lru;
+    EntryIndex index;
+    FrequencySketch sketch;
+    size_t capacity = 0;
+    uint64_t hits = 0, misses = 0, evictions = 0, rejections = 0;
+
+    void resize(size_t c) {
+        capacity = c;
+        while (capacity > 0 && lru.size() > capacity)
+            evict();
+        sketch.reset(capacity);
+    }
+    void evict() {
+        index.erase(std::cref(lru.back().word));
+        lru.pop_back();
+        ++evictions;
+    }
+    void erase(EntryIndex::iterator it) {
+        lru.erase(it->second);
+        index.erase(it);
+    }
+};
+
+Cacheable::Cacheable() : _shards(new Shard[SHARDS]) {
+    for (size_t i = 0; i < SHARDS; ++i)
+        _shards[i].resize(shard_capacity(DEFAULT_CACHE_SIZE, SHARDS));
+}
+
+Cacheable::~Cacheable() = default;
+
+Cacheable::Shard& Cacheable::shard(size_t hash) const {
+    // the low bits select the bucket in the shard's index
+    return _shards[(hash >> (sizeof(size_t) * 4)) % SHARDS];
+}
+
 void Cacheable::set_caching(bool value) {
     _caching.store(value);
     if (!_caching)
@@ -31,24 +186,130 @@ void Cacheable::set_caching(bool value) {
 }
 
 void Cacheable::clear_cache() const {
-    std::unique_lock<std::shared_timed_mutex> write_lock(cache_mutex);
-    _cache.clear();
+    for (size_t i = 0; i < SHARDS; ++i) {
+        Shard& s = _shards[i];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.index.clear();
+        s.lru.clear();
+        s.sketch.clear();
+    }
+}
+
+void Cacheable::invalidate_cache(const WordFilter& affected) const {
+    invalidate_cache_entries([&affected](const string_impl& word,
+                                         const Result&) {
+        return affected(word);
+    });
+}
+
+void Cacheable::invalidate_cache_entries(const EntryFilter& affected) const {
+    // results that are computed from now on get the new version, so
+    // they can't be mixed up with the ones that are retagged here
+    uint64_t version = ++_cache_version;
+    for (size_t i = 0; i < SHARDS; ++i) {
+        Shard& s = _shards[i];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.lru.begin();
+        while (it != s.lru.end()) {
+            if (it->version + 1 == version
+                && !affected(it->word, it->result)) {
+                it->version = version;
+                ++it;
+            } else {
+                s.index.erase(std::cref(it->word));
+                it = s.lru.erase(it);
+            }
+        }
+    }
+}
+
+void Cacheable::set_cache_size(size_t size) {
+    _cache_size.store(size);
+    for (size_t i = 0; i < SHARDS; ++i) {
+        Shard& s = _shards[i];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.resize(shard_capacity(size, SHARDS));
+    }
+}
+
+CacheStats Cacheable::cache_stats() const {
+    CacheStats stats;
+    for (size_t i = 0; i < SHARDS; ++i) {
+        Shard& s = _shards[i];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        stats.hits += s.hits;
+        stats.misses += s.misses;
+        stats.evictions += s.evictions;
+        stats.rejections += s.rejections;
+        stats.entries += s.lru.size();
+    }
+    return stats;
 }
 
 Result Cacheable::query_cache(const string_impl& word) const {
-    std::shared_lock<std::shared_timed_mutex> read_lock(cache_mutex);
-    // _cache has to be checked here, because if we checked from the
-    // outside, it's possible another thread has changed our state between
-    // the call of has_cached() and query_cache()
-    if (_cache.count(word) > 0)
-        return _cache.at(word);
-    return Result();
+    size_t hash = word_hash(word);
+    uint64_t version = cache_version();
+    Shard& s = shard(hash);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.sketch.record(hash);
+    auto it = s.index.find(std::cref(word));
+    if (it != s.index.end() && it->second->version != version) {
+        s.erase(it);
+        it = s.index.end();
+    }
+    if (it == s.index.end()) {
+        ++s.misses;
+        return Result();
+    }
+    ++s.hits;
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+    return it->second->result;
 }
 
 void Cacheable::cache(const string_impl& word, const Result& result) const {
-    std::unique_lock<std::shared_timed_mutex> write_lock(cache_mutex);
-    _cache[word] = result;
+    cache(word, result, cache_version());
+}
+
+void Cacheable::cache(const string_impl& word, const Result& result,
+                      uint64_t version) const {
+    size_t hash = word_hash(word);
+    Shard& s = shard(hash);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    // the result would only be dropped again by the next query
+    if (version != cache_version())
+        return;
+    auto it = s.index.find(std::cref(word));
+    if (it != s.index.end()) {
+        it->second->result = result;
+        it->second->version = version;
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        return;
+    }
+    if (s.capacity > 0 && s.lru.size() >= s.capacity) {
+        // only replace the LRU entry with a word that is looked up more
+        // often, unless that entry is outdated anyway
+        const Shard::Entry& victim = s.lru.back();
+        if (victim.version == version && s.sketch.estimate(hash)
+                <= s.sketch.estimate(word_hash(victim.word))) {
+            ++s.rejections;
+            return;
+        }
+        s.evict();
+    }
+    s.lru.emplace_front(word, result, version);
+    s.index.emplace(std::cref(s.lru.front().word), s.lru.begin());
+}
+
+void Cacheable::set_cache_params(const std::string& name,
+                                 const std::map<std::string, std::string>&
+                                                                      params) {
+    if (params.count(name + ".cache_size") != 0) {
+        std::stringstream ss;
+        size_t size;
+        ss << params.at(name + ".cache_size");
+        if (ss >> size)
+            set_cache_size(size);
+    }
 }
 }  // namespace Normalizer
 }  // namespace Norma
-
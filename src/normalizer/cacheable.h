@@ -18,30 +18,105 @@
 #ifndef NORMALIZER_CACHEABLE_H_
 #define NORMALIZER_CACHEABLE_H_
 #include<atomic>
+#include<cstddef>
+#include<cstdint>
+#include<functional>
 #include<map>
-#include<shared_mutex>
+#include<memory>
+#include<string>
 #include"normalizer/result.h"
 #include"string_impl.h"
 
 namespace Norma {
 namespace Normalizer {
+/// Counters of a Cacheable, summed over all shards
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    /// entries dropped to make room for new ones
+    uint64_t evictions = 0;
+    /// new entries that weren't admitted because they were
+    /// less frequent than the entry they would have replaced
+    uint64_t rejections = 0;
+    size_t entries = 0;
+};
+
+/// Selects words, e.g. those whose results were changed by training
+typedef std::function<bool(const string_impl&)> WordFilter;
+
+/// Bounded cache of normalization results.
+/** The cache is split into shards by the hash of the word, each with its
+ *  own lock, LRU list and frequency sketch, so threads looking up
+ *  different words rarely wait for each other.  When a shard is full, a
+ *  new word only replaces the least recently used entry if it has been
+ *  looked up more often recently, so a stream of rare words can't push
+ *  out frequent ones.
+ *
+ *  The size is configured per normalizer with `<name>.cache_size`
+ *  (number of entries, 0 for no limit), see set_cache_params().
+ **/
 class Cacheable {
  public:
+     Cacheable();
+     ~Cacheable();
+     Cacheable(const Cacheable& a) = delete;
+     const Cacheable& operator=(const Cacheable& a) = delete;
+
      void set_caching(bool value);
      bool is_caching() const { return _caching.load(); }
      void clear_cache() const;
+     /// Maximum number of cached results, 0 means unlimited
+     size_t get_cache_size() const { return _cache_size.load(); }
+     /// Set the maximum number of cached results, 0 means unlimited
+     /** Drops the least recently used entries if the cache
+      *  holds more than that.
+      **/
+     void set_cache_size(size_t size);
+     /// Hit, miss and eviction counters since construction
+     CacheStats cache_stats() const;
+     /// Current version of the cache contents
+     uint64_t cache_version() const { return _cache_version.load(); }
+     /// Mark all cached results as outdated
+     /** Unlike clear_cache(), this doesn't take any locks; outdated
+      *  entries count as misses and are dropped when they're found.
+      **/
+     void invalidate_cache() const { ++_cache_version; }
+     /// Mark only the cached results of the affected words as outdated
+     /** Entries of all other words that were up to date are moved to
+      *  the new version.  affected is called with the shard locks held,
+      *  so it must not use this cache.
+      **/
+     void invalidate_cache(const WordFilter& affected) const;
+
+     static const size_t DEFAULT_CACHE_SIZE = 100000;
 
  protected:
      Result query_cache(const string_impl& word) const;
      void cache(const string_impl& word, const Result& result) const;
+     /// cache a result that was computed at the given cache_version();
+     /// it is discarded if the cache was invalidated in the meantime
+     void cache(const string_impl& word, const Result& result,
+                uint64_t version) const;
+     typedef std::function<bool(const string_impl&, const Result&)>
+             EntryFilter;
+     /// like invalidate_cache(const WordFilter&), for when the cached
+     /// result tells which words are affected
+     void invalidate_cache_entries(const EntryFilter& affected) const;
+     /// read `<name>.cache_size` from params
+     void set_cache_params(const std::string& name,
+                           const std::map<std::string, std::string>& params);
 
  private:
+     struct Shard;
+     static const size_t SHARDS = 16;
+     Shard& shard(size_t hash) const;
+
      std::atomic_bool _caching {true};
-     mutable std::map<string_impl, Result> _cache;
-     mutable std::shared_timed_mutex cache_mutex;
+     std::atomic<size_t> _cache_size {DEFAULT_CACHE_SIZE};
+     mutable std::atomic<uint64_t> _cache_version {0};
+     std::unique_ptr<Shard[]> _shards;
 };
 }  // namespace Normalizer
 }  // namespace Norma
 
 #endif  // NORMALIZER_CACHEABLE_H_
-
@@ -100,12 +100,19 @@ void set_path(const char* path_par) {
 }
 }  // namespace
 
+std::vector<std::string> External::param_files() const {
+    return {_script_file};
+}
+
 void External::init() {
     std::lock_guard<std::mutex> guard(*python_mutex);
     PyEval_AcquireLock();
     temp_state = PyThreadState_Swap(my_threadstate);
-    if (_params->count(_name + ".path") != 0)
+    _script_file = _params->at(_name + ".script") + ".py";
+    if (_params->count(_name + ".path") != 0) {
         set_path(_params->at(_name + ".path").c_str());
+        _script_file = _params->at(_name + ".path") + "/" + _script_file;
+    }
 
     PyObject *sname =
         PyString_FromString(_params->at(_name + ".script").c_str());
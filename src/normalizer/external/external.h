@@ -22,6 +22,7 @@
 #include<string>
 #include<memory>
 #include<mutex>
+#include<vector>
 #include"normalizer/base.h"
 #include"normalizer/result.h"
 
@@ -61,6 +62,7 @@ class External : public Base {
      void init();
      using Base::init;
      void set_from_params(const std::map<std::string, std::string>& params);
+     std::vector<std::string> param_files() const;
 
  protected:
      bool do_train(TrainingData* data);
@@ -73,6 +75,8 @@ class External : public Base {
      void tear_down();
      std::unique_ptr<std::mutex> python_mutex;
      const std::map<std::string, std::string>* _params;
+     /// the script as found on the configured path
+     std::string _script_file;
      bool _initialized = false;
 
      PyObject* get_function_ptr(const char* name);
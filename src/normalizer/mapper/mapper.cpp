@@ -19,6 +19,7 @@
 #include<algorithm>
 #include<functional>
 #include<map>
+#include<set>
 #include<sstream>
 #include<stdexcept>
 #include<string>
@@ -50,6 +51,7 @@ void Mapper::init() {
 
 void Mapper::clear() {
     _map.clear();
+    _trained_words.clear();
 }
 
 Result Mapper::do_normalize(const string_impl& word) const {
@@ -96,14 +98,24 @@ ResultSet Mapper::make_all_results(const string_impl& word) const {
 }
 
 bool Mapper::do_train(TrainingData* data) {
+    _trained_words.clear();
     for (auto pp = data->rbegin(); pp != data->rend(); ++pp) {
         if (pp->is_used())
             break;
         this->do_train(pp->source(), pp->target(), 1);
+        _trained_words.insert(pp->source());
     }
     return true;
 }
 
+WordFilter Mapper::do_affected_by_training() const {
+    // the results only depend on the row of the word itself
+    std::set<string_impl> words = _trained_words;
+    return [words](const string_impl& word) {
+        return words.count(word) != 0;
+    };
+}
+
 void Mapper::do_train(const string_impl& word,
                    const string_impl& modern,
                    int count) {
@@ -18,6 +18,7 @@
 #ifndef NORMALIZER_MAPPER_MAPPER_H_
 #define NORMALIZER_MAPPER_MAPPER_H_
 #include<map>
+#include<set>
 #include<string>
 #include<fstream>
 #include<tuple>
@@ -41,6 +42,7 @@ class Mapper : public Base {
          _mapfile = mapfile;
          return *this;
      }
+     std::vector<std::string> param_files() const { return {_mapfile}; }
      // this needs to be public because it is exposed to python bindings
      void do_train(const string_impl& word, const string_impl& modern,
                    int count);
@@ -50,6 +52,8 @@ class Mapper : public Base {
      Result do_normalize(const string_impl& word) const;
      ResultSet do_normalize(const string_impl& word, unsigned int n) const;
      void do_save_params();
+     /// only the source words of the last training pairs
+     WordFilter do_affected_by_training() const;
 
  private:
      ResultSet make_all_results(const string_impl& word) const;
@@ -58,6 +62,8 @@ class Mapper : public Base {
 
      std::map<string_impl, std::map<string_impl, int>> _map;
      std::string _mapfile;
+     /// source words of the last call to do_train(TrainingData*)
+     std::set<string_impl> _trained_words;
 };
 }  // namespace Mapper
 }  // namespace Normalizer
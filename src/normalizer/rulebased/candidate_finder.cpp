@@ -43,7 +43,7 @@ CandidateFinder::CandidateFinder(const string_impl& word,
     _total_steps = (2 * word.length()) + 1;
     // this is experimental -- not clear what the best setting is:
     _minimum_combined_frequency = 2 * _rules->get_average_freq();
-    _q.push(RAState(word));
+    _q.push(RAState(word, _lex->cursor()));
 }
 
 Result CandidateFinder::operator()() {
@@ -51,7 +51,7 @@ Result CandidateFinder::operator()() {
         const RAState current = _q.top();
         _q.pop();
         if (current.end_of_word()) {
-            if (!_lex->contains(current.norm)) {
+            if (!current.lex_state.is_final()) {
                 continue;
             } else {  // success!
                 Result result = Result(current.norm,
@@ -68,10 +68,12 @@ Result CandidateFinder::operator()() {
             }
         }
 
-        string_impl current_back;
+        string_impl current_back, current_left = current.left();
         extract(word_bound, current.pos, word_bound.length(), &current_back);
+        _probes.push_back({current_left[current_left.length() - 1],
+                           current.pos, current.epsilon});
         iterate_over_rules(current,
-                           _rules->find_applicable_rules(current.left(),
+                           _rules->find_applicable_rules(current_left,
                                                          current_back,
                                                          current.epsilon));
     }
@@ -87,10 +89,12 @@ void CandidateFinder::iterate_over_rules(const RAState& current,
     int combined_freq = calculate_combined_frequency(applicable_rules);
     for (const Rule& rule : applicable_rules) {
         RAState next = current;
-        if (rule.to() != Symbols::EPSILON)
+        if (rule.to() != Symbols::EPSILON) {
             next.norm += rule.to();
-        if (!_lex->contains_partial(next.norm))
-            continue;
+            // only the new part has to be looked up
+            if (!next.lex_state.advance(rule.to()))
+                continue;
+        }
         if (!current.epsilon)
             next.pos += rule.from().length();
         next.epsilon = !current.epsilon;
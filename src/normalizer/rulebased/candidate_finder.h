@@ -22,14 +22,15 @@
 #include<queue>
 #include<functional>
 #include<string>
+#include<tuple>
 #include"string_impl.h"
 #include"symbols.h"
 #include"normalizer/result.h"
+#include"lexicon/lexicon_interface.h"
 #include"rule.h"
 
 namespace Norma {
 namespace Normalizer {
-class LexiconInterface;
 namespace Rulebased {
 class RuleCollection;
 
@@ -41,6 +42,7 @@ struct RAState {
     bool epsilon;               // if true, we're in the epsilon slot before
                                 // the position
     string_impl norm;           // normalization generated so far
+    LexiconInterface::Cursor lex_state;  // position of norm in the lexicon
     string_impl _word;
     std::vector<Rule> history;  // rules applied in this path
 
@@ -48,9 +50,9 @@ struct RAState {
         return (is_empty(norm) ? from_char(Symbols::BOUNDARY) : norm);
     }
 
-    explicit RAState(const string_impl& word)
-        : fscore(0.0), cost(0.0), pos(0), epsilon(true), norm(""), _word(word)
-        {}
+    RAState(const string_impl& word, const LexiconInterface::Cursor& lex)
+        : fscore(0.0), cost(0.0), pos(0), epsilon(true), norm(""),
+          lex_state(lex), _word(word) {}
     RAState(double f, double c, unsigned int p, bool e, string_impl n,
             std::vector<Rule> h) : fscore(f), cost(c), pos(p), epsilon(e),
                                    norm(n), history(h) {}
@@ -64,6 +66,25 @@ struct RAState {
     }
 };
 
+/// A lookup of applicable rules during the search
+/** Only rules matching one of the probes of a word could change
+ *  its result, see Rulebased::do_affected_by_training().
+ **/
+struct RuleProbe {
+    char_impl left;             // last character of the normalization
+    string_size pos;            // position in the word
+    bool epsilon;               // lookup for the epsilon slot
+
+    bool operator<(const RuleProbe& that) const {
+        return std::tie(pos, epsilon, left)
+             < std::tie(that.pos, that.epsilon, that.left);
+    }
+    bool operator==(const RuleProbe& that) const {
+        return pos == that.pos && epsilon == that.epsilon
+            && left == that.left;
+    }
+};
+
 class CandidateFinder {
  public:
     CandidateFinder() = delete;
@@ -72,6 +93,8 @@ class CandidateFinder {
                     const LexiconInterface& lex,
                     const std::string& name);
     Result operator()();
+    /// the rule lookups made so far, with duplicates
+    const std::vector<RuleProbe>& probes() const { return _probes; }
 
  private:
     void iterate_over_rules(const RAState& current,
@@ -92,6 +115,7 @@ class CandidateFinder {
     int _minimum_combined_frequency;
     std::priority_queue<RAState, std::vector<RAState>,
                         std::greater<RAState>> _q;
+    std::vector<RuleProbe> _probes;
     std::map<std::tuple<int, bool, string_impl>, double> best_fscore;
 };
 
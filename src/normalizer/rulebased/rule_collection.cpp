@@ -16,6 +16,7 @@
  * with Norma.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include"rule_collection.h"
+#include<algorithm>
 #include<iostream>
 #include<fstream>
 #include<sstream>
@@ -68,6 +69,9 @@ std::vector<Rule> RuleCollection::find_applicable_rules(const string_impl& left,
             applicable_rules.push_back(rule);
         }
     }
+    // the order decides between candidates of equal cost, so it
+    // mustn't depend on the other rules in the hash table
+    std::sort(applicable_rules.begin(), applicable_rules.end());
     return applicable_rules;
 }
 
@@ -16,14 +16,19 @@
  * with Norma.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include"rulebased.h"
+#include<algorithm>
+#include<cstdint>
 #include<map>
 #include<mutex>
 #include<string>
+#include<utility>
+#include<vector>
 #include"normalizer/result.h"
 #include"normalizer/cacheable.h"
 #include"interface/iobase.h"
 #include"rule.h"
 #include"candidate_finder.h"
+#include"symbols.h"
 
 namespace Norma {
 namespace Normalizer {
@@ -36,16 +41,25 @@ void Rulebased::set_from_params(const std::map<std::string, std::string>&
     else if (params.count("perfilemode.input") != 0)
         set_rulesfile(with_extension(params.at("perfilemode.input"),
                                      _name + ".rulesfile"));
+    set_cache_params(_name, params);
 }
 
 void Rulebased::init() {
     clear();
     if (!_rulesfile.empty())
         _rules.read_rulesfile(_rulesfile);
+    if (_lex != nullptr)
+        _lex_revision = _lex->revision();
 }
 
 void Rulebased::clear() {
     _rules.clear();
+    _trained_rules.clear();
+    _trained_all = true;
+    {
+        std::lock_guard<std::mutex> lock(_probes_mutex);
+        _probes.clear();
+    }
     clear_cache();
 }
 
@@ -72,6 +86,8 @@ Result Rulebased::do_normalize(const string_impl& word) const {
 ResultSet Rulebased::do_normalize(const string_impl& word,
                                   unsigned int n) const {
     ResultSet resultset;
+    if (_lex == nullptr)
+        return resultset;
     Result unchanged_result = make_result(word, 0.0);
     CandidateFinder finder(word, _rules, *_lex, _name);
     for (unsigned int i = 0; i < n; ++i) {
@@ -80,21 +96,83 @@ ResultSet Rulebased::do_normalize(const string_impl& word,
             break;
         resultset.push_back(result);
     }
+    store_probes(word, finder.probes());
     return resultset;
 }
 
+void Rulebased::store_probes(const string_impl& word,
+                             std::vector<RuleProbe> probes) const {
+    std::sort(probes.begin(), probes.end());
+    probes.erase(std::unique(probes.begin(), probes.end()), probes.end());
+    std::lock_guard<std::mutex> lock(_probes_mutex);
+    // words without probes count as affected by any training,
+    // so it's safe to forget them
+    size_t limit = get_cache_size();
+    if (limit > 0 && _probes.size() >= limit && _probes.count(word) == 0)
+        _probes.clear();
+    _probes[word] = std::move(probes);
+}
+
+bool Rulebased::matches_probes(const string_impl& word,
+                               const std::vector<Rule>& rules) const {
+    std::lock_guard<std::mutex> lock(_probes_mutex);
+    auto entry = _probes.find(word);
+    if (entry == _probes.end())
+        return true;
+    string_impl word_bound = word + Symbols::BOUNDARY, back;
+    for (const RuleProbe& probe : entry->second) {
+        bool extracted = false;
+        for (const Rule& rule : rules) {
+            if (!rule.matches_left(probe.left))
+                continue;
+            if (!extracted) {
+                extract(word_bound, probe.pos, word_bound.length(), &back);
+                extracted = true;
+            }
+            if (rule.matches_back(back, probe.epsilon))
+                return true;
+        }
+    }
+    return false;
+}
+
 bool Rulebased::do_train(TrainingData* data) {
+    int average_freq = _rules.get_average_freq();
+    _trained_rules.clear();
     for (auto pp = data->rbegin(); pp != data->rend(); ++pp) {
         if (pp->is_used())
             break;
-        _rules.learn_ruleset(learn_rules(pp->source(),
-                                         pp->target(),
-                                         true, true));
+        RuleSet ruleset = learn_rules(pp->source(), pp->target(),
+                                      true, true);
+        _rules.learn_ruleset(ruleset);
+        _trained_rules.insert(_trained_rules.end(),
+                              ruleset.cbegin(), ruleset.cend());
     }
-    clear_cache();
+    std::sort(_trained_rules.begin(), _trained_rules.end());
+    _trained_rules.erase(std::unique(_trained_rules.begin(),
+                                     _trained_rules.end()),
+                         _trained_rules.end());
+    // the average frequency is part of the cost of every step, and
+    // new words in the lexicon may be candidates for any word
+    uint64_t lex_revision = _lex != nullptr ? _lex->revision() : 0;
+    _trained_all = average_freq != _rules.get_average_freq()
+                || lex_revision != _lex_revision;
+    _lex_revision = lex_revision;
+    invalidate_cache(do_affected_by_training());
     return true;
 }
 
+WordFilter Rulebased::do_affected_by_training() const {
+    if (_trained_all)
+        return [](const string_impl&) { return true; };
+    // a rule can only change the result of a word if the search
+    // for it looked for rules where this one applies
+    std::vector<Rule> rules = _trained_rules;
+    return [this, rules](const string_impl& word) {
+        return matches_probes(word, rules);
+    };
+}
+
 void Rulebased::do_save_params() {
     _rules.save_rulesfile(_rulesfile);
 }
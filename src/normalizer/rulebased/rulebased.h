@@ -17,8 +17,11 @@
  */
 #ifndef NORMALIZER_RULEBASED_RULEBASED_H_
 #define NORMALIZER_RULEBASED_RULEBASED_H_
+#include<cstdint>
 #include<map>
+#include<mutex>
 #include<string>
+#include<vector>
 #include"string_impl.h"
 #include"normalizer/base.h"
 #include"normalizer/cacheable.h"
@@ -46,20 +49,43 @@ class Rulebased : public Base, public Cacheable {
          _rulesfile = rulesfile;
          return *this;
      }
+     std::vector<std::string> param_files() const { return {_rulesfile}; }
 
      using Cacheable::set_caching;
      using Cacheable::clear_cache;
      using Cacheable::is_caching;
+     using Cacheable::get_cache_size;
+     using Cacheable::set_cache_size;
+     using Cacheable::cache_stats;
 
  protected:
      bool do_train(TrainingData* data);
      Result do_normalize(const string_impl& word) const;
      ResultSet do_normalize(const string_impl& word, unsigned int n) const;
      void do_save_params();
+     /// the words where one of the trained rules could be applied
+     WordFilter do_affected_by_training() const;
 
  private:
+     /// remember where the search for word looked up rules
+     void store_probes(const string_impl& word,
+                       std::vector<RuleProbe> probes) const;
+     /// check if any of rules matches where the last search
+     /// for word looked up rules
+     bool matches_probes(const string_impl& word,
+                         const std::vector<Rule>& rules) const;
+
      std::string _rulesfile;
      RuleCollection _rules;
+     /// rules whose frequency was changed by the last training
+     std::vector<Rule> _trained_rules;
+     /// whether the last training may have changed the results
+     /// of any word, regardless of the rules
+     bool _trained_all = true;
+     /// lexicon revision at the last training
+     uint64_t _lex_revision = 0;
+     mutable std::mutex _probes_mutex;
+     mutable std::map<string_impl, std::vector<RuleProbe>> _probes;
 };
 }  // namespace Rulebased
 }  // namespace Normalizer
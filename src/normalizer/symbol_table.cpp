@@ -0,0 +1,71 @@
+/* Copyright 2013-2016 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include"symbol_table.h"
+#include<mutex>
+#include<stdexcept>
+#include"string_impl.h"
+
+namespace Norma {
+namespace Normalizer {
+const SymbolId SymbolTable::NO_SYMBOL;
+
+SymbolTable& SymbolTable::global() {
+    static SymbolTable table;
+    return table;
+}
+
+void SymbolTable::intern(const string_impl& word, SymbolString* out) {
+    out->resize(word.length());
+    for (string_size i = 0; i < word.length(); ++i)
+        (*out)[i] = intern(word[i]);
+}
+
+SymbolId SymbolTable::find(char_impl c) const {
+    if (CharIds::is_dense(c))
+        return _ids.slot(c)->load(std::memory_order_acquire);
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+    const std::atomic<SymbolId>* id = _ids.slot(c);
+    return id == nullptr ? NO_SYMBOL : id->load(std::memory_order_relaxed);
+}
+
+char_impl SymbolTable::character(SymbolId id) const {
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+    if (id == NO_SYMBOL || id > _chars.size())
+        throw std::out_of_range("unknown symbol id");
+    return _chars[id - 1];
+}
+
+size_t SymbolTable::size() const {
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+    return _chars.size();
+}
+
+SymbolId SymbolTable::add(char_impl c) {
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
+    std::atomic<SymbolId>& slot = _ids[c];
+    // another thread may have added c while we were waiting
+    SymbolId id = slot.load(std::memory_order_relaxed);
+    if (id != NO_SYMBOL)
+        return id;
+    _chars.push_back(c);
+    id = static_cast<SymbolId>(_chars.size());
+    slot.store(id, std::memory_order_release);
+    return id;
+}
+}  // namespace Normalizer
+}  // namespace Norma
@@ -0,0 +1,87 @@
+/* Copyright 2013-2016 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef NORMALIZER_SYMBOL_TABLE_H_
+#define NORMALIZER_SYMBOL_TABLE_H_
+#include<atomic>
+#include<cstdint>
+#include<shared_mutex>
+#include<vector>
+#include"string_impl.h"
+
+namespace Norma {
+namespace Normalizer {
+/// Numeric ID of an interned character
+typedef uint32_t SymbolId;
+/// A word as a sequence of interned characters, one ID per character
+typedef std::vector<SymbolId> SymbolString;
+
+/// Maps characters to small, dense integer IDs.
+/** PluginSocket interns each word once via the global() table and
+ *  hands the resulting SymbolString to every normalizer in the chain,
+ *  so normalizers can translate words to their own labels with a
+ *  table lookup per character instead of creating a string for each.
+ *
+ *  IDs are assigned in order of first occurrence, starting at 1, and
+ *  never change for the lifetime of the table.  Lookups of known
+ *  characters in the BMP don't take a lock.
+ **/
+class SymbolTable {
+ public:
+     SymbolTable() = default;
+     SymbolTable(const SymbolTable& a) = delete;
+     const SymbolTable& operator=(const SymbolTable& a) = delete;
+
+     /// The table shared by all normalizers
+     static SymbolTable& global();
+
+     /// Get the ID of a character, assigning a new one if needed
+     SymbolId intern(char_impl c) {
+         if (CharIds::is_dense(c)) {
+             SymbolId id = _ids.slot(c)->load(std::memory_order_acquire);
+             if (id != NO_SYMBOL)
+                 return id;
+         }
+         return add(c);
+     }
+     /// Intern every character of a word
+     void intern(const string_impl& word, SymbolString* out);
+     /// Get the ID of a character, or NO_SYMBOL if it wasn't interned yet
+     SymbolId find(char_impl c) const;
+     /// Get the character for an ID
+     /** Throws std::out_of_range for IDs that weren't assigned.
+      **/
+     char_impl character(SymbolId id) const;
+     /// Number of IDs assigned so far, i.e. the largest assigned ID
+     size_t size() const;
+
+     /// ID that is never assigned to a character
+     static const SymbolId NO_SYMBOL = 0;
+
+ private:
+     typedef DenseCharMap<std::atomic<SymbolId>> CharIds;
+     SymbolId add(char_impl c);
+
+     /// the dense part is read without holding _mutex
+     CharIds _ids;
+     std::vector<char_impl> _chars;
+     mutable std::shared_timed_mutex _mutex;
+};
+}  // namespace Normalizer
+}  // namespace Norma
+
+#endif  // NORMALIZER_SYMBOL_TABLE_H_
@@ -17,6 +17,9 @@
  */
 #include"levenshtein_algorithm.h"
 #include<algorithm>
+#include<cstdint>
+#include<functional>
+#include<limits>
 #include<vector>
 #include"typedefs.h"
 #include"weight_set.h"
@@ -29,23 +32,38 @@ namespace Norma {
 namespace Normalizer {
 namespace WLD {
 namespace {
-inline RuleSet copy_push_back(const RuleSet& rs, const EditPair& ep) {
-    RuleSet new_rs(rs); new_rs.push_back(ep); return new_rs;
+typedef vector<string_impl>::size_type vec_size;
+
+// the steps into a cell of the distance matrix, as bits of a mask
+const uint8_t STEP_INSERTION    = 1;
+const uint8_t STEP_DELETION     = 2;
+const uint8_t STEP_SUBSTITUTION = 4;
+const uint8_t ALL_STEPS[] = {STEP_INSERTION, STEP_DELETION,
+                             STEP_SUBSTITUTION};
+
+// alignment counts grow exponentially with the length of the words,
+// so they stop at the largest value instead of wrapping around
+const uint64_t MAX_COUNT = std::numeric_limits<uint64_t>::max();
+
+uint64_t add_counts(uint64_t a, uint64_t b) {
+    return a > MAX_COUNT - b ? MAX_COUNT : a + b;
 }
 
-typedef vector<string_impl>::size_type vec_size;
+uint64_t multiply_counts(uint64_t a, uint64_t b) {
+    return b != 0 && a > MAX_COUNT / b ? MAX_COUNT : a * b;
+}
 
 class WldLogic {
  protected:
      // set from the ctor
-     const vector<string_impl>& _source, & _target;
      const WeightSet& ws;
 
      // calculated (cached) by the ctor
      vec_size source_len, target_len;
+     vector<WeightSet::SymbolIndex> source_ids, target_ids;
+     vector<double> ins_weights, del_weights;
 
      // calculated in the methods and held here for following methods
-     EditPair ins_pair, del_pair, sub_pair;
      std::vector<double> this_row, next_row;
      double best_cost, ins_cost, del_cost, sub_cost;
 
@@ -53,9 +71,15 @@ class WldLogic {
      WldLogic(const vector<string_impl>& source,
               const vector<string_impl>& target,
               const WeightSet& weights)
-         : _source(source), _target(target), ws(weights),
-           source_len(source.size()), target_len(target.size()),
-           this_row(target_len+1), next_row(target_len+1) {}
+         : ws(weights), source_len(source.size()),
+           target_len(target.size()),
+           this_row(target_len+1), next_row(target_len+1) {
+         ws.encode(source, target, &source_ids, &target_ids);
+         for (auto id : target_ids)
+             ins_weights.push_back(ws.get_weight(WeightSet::EPS_INDEX, id));
+         for (auto id : source_ids)
+             del_weights.push_back(ws.get_weight(id, WeightSet::EPS_INDEX));
+     }
 
      virtual vec_size slen() { return source_len; }
      virtual vec_size tlen() { return target_len; }
@@ -65,24 +89,20 @@ class WldLogic {
      virtual void init_toprow() {
          this_row[0] = 0;
          for (vec_size tpos = 0; tpos < target_len; ++tpos)
-             this_row[tpos+1] = this_row[tpos]
-                 + ws.get_weight(EditPair({}, {_target[tpos]}));
+             this_row[tpos+1] = this_row[tpos] + ins_weights[tpos];
      }
      // called once _before_ every inner (target) loop,
      // it initializes the left column of the next row
      virtual void init_leftcolumn(vec_size spos) {
-         next_row[0] = this_row[0]
-             + ws.get_weight(EditPair({_source[spos]}, {}));
+         next_row[0] = this_row[0] + del_weights[spos];
      }
      // called on every iteration of the inner main loop,
      // it fills the rest of the next row
      virtual void main_body(vec_size spos, vec_size tpos) {
-         ins_pair = EditPair({}, {_target[tpos]});
-         del_pair = EditPair({_source[spos]}, {});
-         sub_pair = EditPair({_source[spos]}, {_target[tpos]});
-         ins_cost = next_row[tpos] + ws.get_weight(ins_pair);
-         del_cost = this_row[tpos+1] + ws.get_weight(del_pair);
-         sub_cost = this_row[tpos] + ws.get_weight(sub_pair);
+         ins_cost = next_row[tpos] + ins_weights[tpos];
+         del_cost = this_row[tpos+1] + del_weights[spos];
+         sub_cost = this_row[tpos]
+             + ws.get_weight(source_ids[spos], target_ids[tpos]);
          best_cost = std::min({ins_cost, del_cost, sub_cost});
          next_row[tpos+1] = best_cost;
      }
@@ -100,50 +120,38 @@ class WldLogic {
 };
 
 // for documentation on the methods, see the base class above
-class AlignLogic : public WldLogic {
+class StepLogic : public WldLogic {
  private:
-     vector<AlignmentSet> this_edit, next_edit;
+     vector<uint8_t>* _steps;
+     vec_size _width;
 
  public:
-     AlignLogic(const vector<string_impl>& source,
-                const vector<string_impl>& target,
-                const WeightSet& weights)
-         : WldLogic(source, target, weights),
-           this_edit(target_len+1), next_edit(target_len+1) {}
+     StepLogic(const vector<string_impl>& source,
+               const vector<string_impl>& target,
+               const WeightSet& weights, vector<uint8_t>* steps)
+         : WldLogic(source, target, weights), _steps(steps),
+           _width(target_len+1) {
+         _steps->assign((source_len+1) * _width, 0);
+     }
      void init_toprow() {
          WldLogic::init_toprow();
-         this_edit[0] = {{}};
-         for (vec_size tpos = 0; tpos < target_len; ++tpos) {
-             EditPair p({}, {_target[tpos]});
-             this_edit[tpos+1] = { copy_push_back(this_edit[tpos][0], p) };
-         }
+         for (vec_size tpos = 0; tpos < target_len; ++tpos)
+             (*_steps)[tpos+1] = STEP_INSERTION;
      }
      void init_leftcolumn(vec_size spos) {
          WldLogic::init_leftcolumn(spos);
-         next_edit[0].push_back(copy_push_back(this_edit[0][0],
-                                EditPair({_source[spos]}, {})));
+         (*_steps)[(spos+1) * _width] = STEP_DELETION;
      }
      void main_body(vec_size spos, vec_size tpos) {
          WldLogic::main_body(spos, tpos);
-         auto update_edit = [&](AlignmentSet s, EditPair p) {
-             for (const auto& rs : s)
-                 next_edit[tpos+1].push_back(copy_push_back(rs, p));
-         };  // NOLINT[readability/braces]
-         // the lint target seems to ignore the previous NOLINT, idk why
-         next_edit[tpos+1] = {};
+         uint8_t steps = 0;
          if (ins_cost <= best_cost)
-             update_edit(next_edit[tpos], ins_pair);
+             steps |= STEP_INSERTION;
          if (del_cost <= best_cost)
-             update_edit(this_edit[tpos+1], del_pair);
+             steps |= STEP_DELETION;
          if (sub_cost <= best_cost)
-             update_edit(this_edit[tpos], sub_pair);
-     }
-     void make_swap() {
-         WldLogic::make_swap();
-         this_edit.swap(next_edit);
-     }
-     AlignmentSet get_result() {
-         return this_edit[target_len];
+             steps |= STEP_SUBSTITUTION;
+         (*_steps)[(spos+1) * _width + tpos+1] = steps;
      }
 };
 
@@ -162,6 +170,100 @@ void main_loop(WldLogic* logic) {
 
 }  // namespace
 
+AlignmentGraph::AlignmentGraph(const std::vector<string_impl>& source,
+                               const std::vector<string_impl>& target,
+                               const WeightSet& weights)
+    : _source(source), _target(target), _width(target.size() + 1) {
+    StepLogic logic(_source, _target, weights, &_steps);
+    main_loop(&logic);
+}
+
+AlignmentGraph::AlignmentGraph(const WordPair& p, const WeightSet& weights)
+    : AlignmentGraph(Gfsm::explode(p.first), Gfsm::explode(p.second),
+                     weights) {}
+
+EditPair AlignmentGraph::edit(size_t spos, size_t tpos, uint8_t step) const {
+    EditPair ep;
+    if (step != STEP_INSERTION)
+        ep.first.push_back(_source[spos - 1]);
+    if (step != STEP_DELETION)
+        ep.second.push_back(_target[tpos - 1]);
+    return ep;
+}
+
+std::vector<uint64_t> AlignmentGraph::count_from_start() const {
+    std::vector<uint64_t> counts(_steps.size(), 0);
+    counts[0] = 1;
+    for (size_t spos = 0; spos <= _source.size(); ++spos)
+        for (size_t tpos = 0; tpos <= _target.size(); ++tpos) {
+            uint8_t steps = _steps[cell(spos, tpos)];
+            uint64_t& count = counts[cell(spos, tpos)];
+            if (steps & STEP_INSERTION)
+                count = add_counts(count, counts[cell(spos, tpos - 1)]);
+            if (steps & STEP_DELETION)
+                count = add_counts(count, counts[cell(spos - 1, tpos)]);
+            if (steps & STEP_SUBSTITUTION)
+                count = add_counts(count,
+                                   counts[cell(spos - 1, tpos - 1)]);
+        }
+    return counts;
+}
+
+uint64_t AlignmentGraph::count() const {
+    return count_from_start().back();
+}
+
+void AlignmentGraph::for_each(
+                     const std::function<void(const RuleSet&)>& f) const {
+    // walks back from the last cell, so the edits are collected in
+    // reverse; trying the steps in the same order as the old
+    // implementation keeps the order of the alignments
+    RuleSet reversed, alignment;
+    std::function<void(size_t, size_t)> walk =
+        [&](size_t spos, size_t tpos) {
+            if (spos == 0 && tpos == 0) {
+                alignment.assign(reversed.rbegin(), reversed.rend());
+                f(alignment);
+                return;
+            }
+            uint8_t steps = _steps[cell(spos, tpos)];
+            for (uint8_t step : ALL_STEPS) {
+                if (!(steps & step))
+                    continue;
+                reversed.push_back(edit(spos, tpos, step));
+                walk(step == STEP_INSERTION ? spos : spos - 1,
+                     step == STEP_DELETION  ? tpos : tpos - 1);
+                reversed.pop_back();
+            }
+        };  // NOLINT[readability/braces]
+    walk(_source.size(), _target.size());
+}
+
+void AlignmentGraph::count_edits(
+        const std::function<void(const EditPair&, uint64_t)>& f) const {
+    // an edit is part of (alignments of the prefixes before it) times
+    // (alignments of the rest after it)
+    std::vector<uint64_t> from_start = count_from_start(),
+                          to_end(_steps.size(), 0);
+    to_end.back() = 1;
+    for (size_t spos = _source.size() + 1; spos-- > 0;)
+        for (size_t tpos = _target.size() + 1; tpos-- > 0;) {
+            uint64_t paths_after = to_end[cell(spos, tpos)];
+            if (paths_after == 0)
+                continue;
+            uint8_t steps = _steps[cell(spos, tpos)];
+            for (uint8_t step : ALL_STEPS) {
+                if (!(steps & step))
+                    continue;
+                size_t prev = cell(step == STEP_INSERTION ? spos : spos - 1,
+                                   step == STEP_DELETION  ? tpos : tpos - 1);
+                to_end[prev] = add_counts(to_end[prev], paths_after);
+                f(edit(spos, tpos, step),
+                  multiply_counts(from_start[prev], paths_after));
+            }
+        }
+}
+
 AlignmentSet align(const string_impl& from, const string_impl& to,
                    const WeightSet& weights) {
     auto source = Gfsm::explode(from),
@@ -176,9 +278,10 @@ AlignmentSet align(const WordPair& p, const WeightSet& weights) {
 AlignmentSet align(const std::vector<string_impl>& source,
                    const std::vector<string_impl>& target,
                    const WeightSet& weights) {
-    AlignLogic logic(source, target, weights);
-    main_loop(&logic);
-    return logic.get_result();
+    AlignmentSet result;
+    AlignmentGraph(source, target, weights).for_each(
+        [&result](const RuleSet& rs) { result.push_back(rs); });
+    return result;
 }
 
 double wld(const string_impl& from, const string_impl& to,
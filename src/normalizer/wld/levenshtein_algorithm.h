@@ -17,6 +17,8 @@
  */
 #ifndef NORMALIZER_WLD_LEVENSHTEIN_ALGORITHM_H_
 #define NORMALIZER_WLD_LEVENSHTEIN_ALGORITHM_H_
+#include<cstdint>
+#include<functional>
 #include<vector>
 #include"string_impl.h"
 #include"typedefs.h"
@@ -26,6 +28,52 @@ namespace Norma {
 namespace Normalizer {
 namespace WLD {
 
+/// The co-optimal alignments of two symbol sequences.
+/** Instead of the alignments themselves, only the edit operations that
+ *  reach each cell of the distance matrix at minimal cost are stored,
+ *  as a bitmask per cell. The alignments can be enumerated one at a
+ *  time from them, and the edits can be counted over all alignments
+ *  without enumerating them at all, which matters when there are many
+ *  ties.
+ */
+class AlignmentGraph {
+ public:
+     AlignmentGraph(const std::vector<string_impl>& source,
+                    const std::vector<string_impl>& target,
+                    const WeightSet& weights);
+     AlignmentGraph(const WordPair& p, const WeightSet& weights);
+
+     /// the number of co-optimal alignments
+     /** This and the counts passed by count_edits() stop at the largest
+      *  uint64_t if there are more alignments than that.
+      */
+     uint64_t count() const;
+     /// call f with every co-optimal alignment, in the order of align()
+     /** The RuleSet is reused, so it is only valid during the call. */
+     void for_each(const std::function<void(const RuleSet&)>& f) const;
+     /// call f with every edit that is part of a co-optimal alignment,
+     /// and the number of alignments it is part of
+     /** The same edit may be passed more than once if it occurs at
+      *  different positions.
+      */
+     void count_edits(const std::function<void(const EditPair&,
+                                               uint64_t)>& f) const;
+
+ private:
+     std::vector<string_impl> _source, _target;
+     /// the steps that reach each cell, row by row
+     std::vector<uint8_t> _steps;
+     size_t _width;
+
+     size_t cell(size_t spos, size_t tpos) const {
+         return spos * _width + tpos;
+     }
+     /// the edit of a step that ends in the given cell
+     EditPair edit(size_t spos, size_t tpos, uint8_t step) const;
+     /// the number of alignments of each prefix pair
+     std::vector<uint64_t> count_from_start() const;
+};
+
 AlignmentSet align(const std::vector<string_impl>& source,
                    const std::vector<string_impl>& target,
                    const WeightSet& weights);
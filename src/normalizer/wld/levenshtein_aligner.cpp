@@ -18,7 +18,10 @@
 #include"levenshtein_aligner.h"
 #include<algorithm>
 #include<cmath>
+#include<functional>
+#include<future>
 #include<limits>
+#include<thread>
 #include<utility>
 #include<vector>
 #include"gfsm_wrapper.h"
@@ -27,39 +30,94 @@
 #include"typedefs.h"
 #include"levenshtein_algorithm.h"
 #include"weight_set.h"
+#include"thread_pool.h"
 
 namespace Norma {
 namespace Normalizer {
 namespace WLD {
+void LevenshteinAligner::CycleCounts::merge(const CycleCounts& other) {
+    for (const auto& rule : other.rules)
+        rules[rule.first].freq += rule.second.freq;
+    for (const auto& ngram : other.source)
+        source[ngram.first] += ngram.second;
+    for (const auto& ngram : other.target)
+        target[ngram.first] += ngram.second;
+}
+
+void LevenshteinAligner::FinalCounts::merge(const FinalCounts& other) {
+    for (const auto& rule : other.rules)
+        rules[rule.first].freq += rule.second.freq;
+    for (const auto& ngram : other.source)
+        source[ngram.first] += ngram.second;
+    for (const auto& types : other.targets)
+        targets[types.first].insert(types.second.begin(), types.second.end());
+    pairs += other.pairs;
+}
+
+template<class Counts>
+Counts LevenshteinAligner::collect_parallel(const TrainSet& pairs,
+                 const std::function<void(const WordPair&, int,
+                                          Counts*)>& collect) const {
+    unsigned int threads = _threads;
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    Counts counts;
+    if (threads == 1 || pairs.size() < 2) {
+        for (const auto& elem : pairs)
+            collect(elem.first, elem.second, &counts);
+        return counts;
+    }
+    // a few chunks per thread, so that they finish at about the same time
+    size_t chunk_size = std::max<size_t>(1, pairs.size() / (4 * threads));
+    ThreadPool pool(threads);
+    std::vector<std::future<Counts>> chunks;
+    for (auto begin = pairs.begin(); begin != pairs.end();) {
+        auto end = begin;
+        for (size_t i = 0; i < chunk_size && end != pairs.end(); ++i)
+            ++end;
+        chunks.push_back(pool.submit([begin, end, &collect]() {
+            Counts chunk;
+            for (auto elem = begin; elem != end; ++elem)
+                collect(elem->first, elem->second, &chunk);
+            return chunk;
+        }));
+        begin = end;
+    }
+    for (auto& chunk : chunks)
+        counts.merge(chunk.get());
+    return counts;
+}
+
 void LevenshteinAligner::perform_training_cycle(const TrainSet& pairs) {
-    RuleStatsMap rules;
-    NgramFrequencyMap freq_source, freq_target;
     // calculate unigram alignments & collect rule frequencies
-    for (const auto& elem : pairs) {
-        collect_unigram_frequencies(&rules, &freq_source, &freq_target,
-                                    align(elem.first, _weights), elem.second);
-    }
+    CycleCounts counts = collect_parallel<CycleCounts>(pairs,
+        [this](const WordPair& pair, int count, CycleCounts* c) {
+            collect_unigram_frequencies(&c->rules, &c->source, &c->target,
+                                        AlignmentGraph(pair, _weights),
+                                        count);
+        });
     // pointwise mutual information
-    auto pmi = calculate_pmi(&rules, freq_source, freq_target);
+    auto pmi = calculate_pmi(&counts.rules, counts.source, counts.target);
     // adjust weights
-    _meandiff = adjust_weights(rules, pmi);
+    _meandiff = adjust_weights(counts.rules, pmi);
 }
 
 WeightSet LevenshteinAligner::make_final_weight_set(const TrainSet& pairs) {
-    RuleStatsMap rules;
-    NgramFrequencyMap freq_source;
-    PairTypesMap targets_per_source;
     WeightSet final;
-    int pair_count = 0;
     // calculate final n-gram alignments & collect frequencies
-    for (const auto& elem : pairs) {
-        collect_frequencies(&rules, &freq_source, &targets_per_source,
-                            align(elem.first, _weights), elem.second);
-        pair_count += elem.second;
-    }
+    FinalCounts counts = collect_parallel<FinalCounts>(pairs,
+        [this](const WordPair& pair, int count, FinalCounts* c) {
+            collect_frequencies(&c->rules, &c->source, &c->targets,
+                                AlignmentGraph(pair, _weights), count);
+            c->pairs += count;
+        });
+    RuleStatsMap& rules = counts.rules;
+    NgramFrequencyMap& freq_source = counts.source;
+    PairTypesMap& targets_per_source = counts.targets;
+    uint64_t pair_count = counts.pairs;
     // calculate final weights
     double alpha = 0.5;
-    int freq_floor = pair_count / 6.293;
+    double freq_floor = std::floor(pair_count / 6.293);
     for (const auto& rule : rules) {
         const EditPair& pair = rule.first;
         const RuleStats& stats = rule.second;
@@ -78,30 +136,23 @@ WeightSet LevenshteinAligner::make_final_weight_set(const TrainSet& pairs) {
 void LevenshteinAligner::collect_unigram_frequencies(RuleStatsMap* fr,
                                                      NgramFrequencyMap* fs,
                                                      NgramFrequencyMap* ft,
-                                                     const AlignmentSet& as,
+                                                     const AlignmentGraph& ag,
                                                      int count) const {
-    for (const RuleSet& rs : as) {
-        for (auto it = rs.begin(); it != rs.end(); ++it) {
-            EditPair ep;
-            (*fr)[ep].freq += count;
-            if ((*fs).count(ep.first) == 0)
-                (*fs)[ep.first]  = count;
-            else
-                (*fs)[ep.first] += count;
-            if ((*ft).count(ep.second) == 0)
-                (*ft)[ep.second]  = count;
-            else
-                (*ft)[ep.second] += count;
-        }
-    }
+    // every edit counts once for each alignment it is part of
+    ag.count_edits([&](const EditPair& ep, uint64_t alignments) {
+        double n = static_cast<double>(count) * alignments;
+        (*fr)[ep].freq += n;
+        (*fs)[ep.first]  += n;
+        (*ft)[ep.second] += n;
+    });
 }
 
 void LevenshteinAligner::collect_frequencies(RuleStatsMap* fr,
                                              NgramFrequencyMap* fs,
                                              PairTypesMap* pt,
-                                             const AlignmentSet& as,
+                                             const AlignmentGraph& ag,
                                              int count) const {
-    for (const RuleSet& rs : as) {
+    ag.for_each([&](const RuleSet& rs) {
         for (auto it = rs.begin(); it != rs.end(); ++it) {
             EditPair ep;
             unsigned int n = 0;
@@ -118,7 +169,7 @@ void LevenshteinAligner::collect_frequencies(RuleStatsMap* fr,
                 (*pt)[ep.first].insert(ep.second);
             }
         }
-    }
+    });
 }
 
 std::tuple<double, double>
@@ -153,7 +204,8 @@ double LevenshteinAligner::adjust_weights(const RuleStatsMap& rules,
             continue;
         if (!_allow_identity && pair.first == pair.second)
             continue;
-        double dist = (max_pmi - stats.pmi) / range_pmi;
+        // all rules are equally good if there's no range
+        double dist = range_pmi > 0 ? (max_pmi - stats.pmi) / range_pmi : 0.0;
         double w_old = _weights.get_weight(pair);
         double w_new = (w_old * (1.0 - _learning_rate))
                        + (_learning_rate * dist);
@@ -17,11 +17,14 @@
  */
 #ifndef NORMALIZER_WLD_LEVENSHTEIN_ALIGNER_H_
 #define NORMALIZER_WLD_LEVENSHTEIN_ALIGNER_H_
+#include<cstdint>
+#include<functional>
 #include<map>
 #include<set>
 #include<tuple>
 #include<vector>
 #include"string_impl.h"
+#include"levenshtein_algorithm.h"
 #include"typedefs.h"
 #include"weight_set.h"
 
@@ -37,6 +40,7 @@ class LevenshteinAligner {
         : _weights(ws), _ngrams(n), _divisor(d) {}
 
     // Performs a PMI training cycle, updating the WeightSet
+    // The pairs are aligned by several threads, see threads()
     void perform_training_cycle(const TrainSet& pairs);
     WeightSet make_final_weight_set(const TrainSet& pairs);
 
@@ -49,16 +53,35 @@ class LevenshteinAligner {
     bool& allow_identity() { return _allow_identity; }
     const bool& allow_identity() const { return _allow_identity; }
     double meandiff() const { return _meandiff; }
+    // Number of threads used for training (0 = one per hardware thread)
+    unsigned int& threads() { return _threads; }
+    const unsigned int& threads() const { return _threads; }
 
  private:
+    // frequencies are weighted by the number of alignments, which
+    // can be too large for an integer type
     struct RuleStats {
-        int freq = 0;
+        double freq = 0;
         double pmi = 0.0;
     };
     typedef std::map<EditPair, RuleStats> RuleStatsMap;
-    typedef std::map<std::vector<string_impl>, int> NgramFrequencyMap;
+    typedef std::map<std::vector<string_impl>, double> NgramFrequencyMap;
     typedef std::map<std::vector<string_impl>,
                      std::set<std::vector<string_impl>>> PairTypesMap;
+    // frequencies collected during a training cycle
+    struct CycleCounts {
+        RuleStatsMap rules;
+        NgramFrequencyMap source, target;
+        void merge(const CycleCounts& other);
+    };
+    // frequencies collected for the final weight set
+    struct FinalCounts {
+        RuleStatsMap rules;
+        NgramFrequencyMap source;
+        PairTypesMap targets;
+        uint64_t pairs = 0;
+        void merge(const FinalCounts& other);
+    };
 
     WeightSet _weights;
     unsigned int _ngrams;
@@ -67,15 +90,24 @@ class LevenshteinAligner {
     double _meandiff = 0;
     bool _allow_pure_insertions = false;
     bool _allow_identity = false;
+    unsigned int _threads = 0;
+
+    // Runs collect on all pairs, split into chunks for the worker
+    // threads, and merges the counts of the chunks in order, so the
+    // result doesn't depend on the number of threads
+    template<class Counts>
+    Counts collect_parallel(const TrainSet& pairs,
+                            const std::function<void(const WordPair&, int,
+                                                     Counts*)>& collect) const;
 
     void collect_unigram_frequencies(RuleStatsMap* fr,
                                      NgramFrequencyMap* fs,
                                      NgramFrequencyMap* ft,
-                                     const AlignmentSet& as,
+                                     const AlignmentGraph& ag,
                                      int count = 1) const;
     void collect_frequencies(RuleStatsMap* fr,
                              NgramFrequencyMap* fs, PairTypesMap* pt,
-                             const AlignmentSet& as, int count = 1) const;
+                             const AlignmentGraph& ag, int count = 1) const;
     std::tuple<double, double> calculate_pmi(RuleStatsMap* rules,
                                              const NgramFrequencyMap& fs,
                                              const NgramFrequencyMap& ft) const;
@@ -0,0 +1,345 @@
+/* Copyright 2013-2016 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include"lexicon_search.h"
+#include<algorithm>
+#include<limits>
+#include<map>
+#include<memory>
+#include<vector>
+#include"gfsm_wrapper.h"
+#include"string_impl.h"
+#include"normalizer/symbol_table.h"
+#include"weight_set.h"
+
+namespace Norma {
+namespace Normalizer {
+namespace WLD {
+namespace {
+const double INFINITE = std::numeric_limits<double>::infinity();
+const uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+
+/// a prefix of lexicon words, i.e. a path from the root
+struct Node {
+    uint32_t parent;
+    gfsmStateId state;
+    gfsmLabelVal label;
+    /// lowest cost any word through this prefix can still reach,
+    /// considering only this node's row
+    double own_bound;
+};
+
+/// a node to expand, or a word that was completed
+struct Item {
+    double priority;
+    uint32_t node;
+    bool complete;
+};
+
+/// orders the heap so that the cheapest item is on top; completed
+/// words go first on ties, so they are returned as early as possible
+struct ItemOrder {
+    bool operator()(const Item& a, const Item& b) const {
+        if (a.priority != b.priority)
+            return a.priority > b.priority;
+        if (a.complete != b.complete)
+            return b.complete;
+        return a.node > b.node;
+    }
+};
+}  // namespace
+
+/// a custom weight that matches the input between start and end
+struct LexiconSearch::Active {
+    uint32_t start;
+    uint32_t end;
+    const Edit* edit;
+};
+
+/// buffers that are reused between the lookups of a thread
+struct LexiconSearch::Workspace {
+    size_t width;
+    std::vector<gfsmLabelVal> labels;
+    /// lower bound for the cost of the rest of the input at each position
+    std::vector<double> rest;
+    /// active edits with output, sorted by their last output label
+    std::vector<Active> outputs;
+    /// active edits without output, sorted by their end
+    std::vector<Active> deletions;
+    std::vector<Node> nodes;
+    /// the distance rows of all nodes, width entries each
+    std::vector<double> rows;
+    std::vector<Item> heap;
+    SymbolString key;
+
+    double* row(uint32_t node) { return &rows[node * width]; }
+};
+
+LexiconSearch::LexiconSearch(const WeightSet& weights,
+                             std::shared_ptr<const Gfsm::CompiledAcceptor> dfa,
+                             const std::vector<string_impl>& symbols,
+                             gfsmLabelVal boundary)
+    : _dfa(std::move(dfa)), _boundary(boundary), _label_symbols(symbols),
+      _identity_cost(weights.default_identity_cost()),
+      _replacement_cost(weights.default_replacement_cost()),
+      _deletion_cost(weights.default_deletion_cost()) {
+    SymbolTable& table = SymbolTable::global();
+    std::map<string_impl, gfsmLabelVal> labels;
+    for (gfsmLabelVal label = 1; label < _label_symbols.size(); ++label) {
+        const string_impl& symbol = _label_symbols[label];
+        if (symbol.length() == 0)
+            continue;
+        labels[symbol] = label;
+        if (symbol.length() != 1)
+            continue;
+        SymbolId id = table.intern(symbol[0]);
+        if (id >= _symbol_labels.size())
+            _symbol_labels.resize(id + 1, 0);
+        _symbol_labels[id] = label;
+    }
+
+    _char_cost = std::min({_identity_cost, _replacement_cost,
+                           _deletion_cost});
+    for (const auto& w : weights.weight_map()) {
+        SymbolString from;
+        Edit edit;
+        bool usable = true;
+        for (const string_impl& symbol : w.first.first) {
+            if (symbol.length() != 1) {
+                usable = false;
+                break;
+            }
+            from.push_back(table.intern(symbol[0]));
+        }
+        for (const string_impl& symbol : w.first.second) {
+            auto label = labels.find(symbol);
+            if (label == labels.end()) {
+                usable = false;
+                break;
+            }
+            edit.to.push_back(label->second);
+        }
+        if (!usable || (from.empty() && edit.to.empty()))
+            continue;
+        edit.from_length = from.size();
+        edit.weight = w.second;
+        _max_from = std::max(_max_from, from.size());
+        _max_to = std::max(_max_to, edit.to.size());
+        if (from.empty()) {
+            _insertions.push_back(std::move(edit));
+        } else {
+            _char_cost = std::min(_char_cost, edit.weight / from.size());
+            _edits[from].push_back(std::move(edit));
+        }
+    }
+    _char_cost = std::max(_char_cost, 0.0);
+}
+
+LexiconSearch::~LexiconSearch() {}
+
+bool LexiconSearch::is_valid() const {
+    return _dfa != nullptr && _dfa->is_valid()
+        && _dfa->root() < _dfa->tables().n_states;
+}
+
+std::vector<Gfsm::StringPath>
+LexiconSearch::lookup(const SymbolString& word,
+                      const Gfsm::LookupParams& params) const {
+    std::vector<Gfsm::StringPath> results;
+    if (!is_valid() || params.max_paths == 0)
+        return results;
+
+    thread_local Workspace ws;
+    size_t n = word.size();
+    ws.width = n + 1;
+    ws.labels.resize(n);
+    ws.rest.resize(n + 1);
+    for (size_t i = 0; i < n; ++i)
+        ws.labels[i] = word[i] < _symbol_labels.size() ? _symbol_labels[word[i]]
+                                                       : 0;
+    for (size_t i = 0; i <= n; ++i)
+        ws.rest[i] = (n - i) * _char_cost;
+    find_active_edits(word, &ws);
+
+    ws.nodes.clear();
+    ws.rows.clear();
+    ws.heap.clear();
+    ws.nodes.push_back(Node{NO_NODE, _dfa->root(), 0, 0.0});
+    ws.rows.resize(ws.width);
+    fill_row(0, &ws);
+    ws.heap.push_back(Item{bound(0, &ws), 0, false});
+
+    ItemOrder order;
+    unsigned int ops = 0;
+    while (!ws.heap.empty()) {
+        std::pop_heap(ws.heap.begin(), ws.heap.end(), order);
+        Item item = ws.heap.back();
+        ws.heap.pop_back();
+        if (item.priority > params.max_weight)
+            break;
+        if (item.complete) {
+            results.push_back(make_path(item.node, item.priority, ws));
+            if (results.size() >= params.max_paths)
+                break;
+            continue;
+        }
+        if (ops++ >= params.max_ops)
+            break;
+        expand(item.node, params.max_weight, &ws);
+    }
+    return results;
+}
+
+void LexiconSearch::find_active_edits(const SymbolString& word,
+                                      Workspace* ws) const {
+    ws->outputs.clear();
+    ws->deletions.clear();
+    uint32_t n = word.size();
+    for (uint32_t i = 0; i < n; ++i) {
+        for (size_t len = 1; len <= _max_from && i + len <= n; ++len) {
+            ws->key.assign(word.begin() + i, word.begin() + i + len);
+            auto edits = _edits.find(ws->key);
+            if (edits == _edits.end())
+                continue;
+            for (const Edit& edit : edits->second) {
+                Active active{i, static_cast<uint32_t>(i + len), &edit};
+                if (edit.to.empty())
+                    ws->deletions.push_back(active);
+                else
+                    ws->outputs.push_back(active);
+            }
+        }
+    }
+    for (uint32_t i = 0; i <= n; ++i)
+        for (const Edit& edit : _insertions)
+            ws->outputs.push_back(Active{i, i, &edit});
+    std::sort(ws->outputs.begin(), ws->outputs.end(),
+              [](const Active& a, const Active& b) {
+                  return a.edit->to.back() < b.edit->to.back();
+              });
+    std::sort(ws->deletions.begin(), ws->deletions.end(),
+              [](const Active& a, const Active& b) {
+                  return a.end < b.end;
+              });
+}
+
+void LexiconSearch::fill_row(uint32_t node, Workspace* ws) const {
+    size_t n = ws->width - 1;
+    double* row = ws->row(node);
+    std::fill(row, row + ws->width, INFINITE);
+    if (node == 0) {
+        row[0] = 0.0;
+    } else {
+        const Node& current = ws->nodes[node];
+        const double* prev = ws->row(current.parent);
+        double identity = std::min(_identity_cost, _replacement_cost);
+        for (size_t i = 1; i <= n; ++i)
+            row[i] = prev[i - 1] + (ws->labels[i - 1] == current.label
+                                    ? identity : _replacement_cost);
+        // custom weights whose output ends with this node's label
+        auto first = std::lower_bound(ws->outputs.begin(), ws->outputs.end(),
+                                      current.label,
+                                      [](const Active& a, gfsmLabelVal l) {
+                                          return a.edit->to.back() < l;
+                                      });
+        for (auto a = first; a != ws->outputs.end()
+                             && a->edit->to.back() == current.label; ++a) {
+            // the output has to match the labels leading here; the row
+            // before the output is the one of the node it starts at
+            const std::vector<gfsmLabelVal>& to = a->edit->to;
+            uint32_t start = node;
+            for (size_t k = to.size(); k-- > 0 && start != NO_NODE;) {
+                if (start == 0 || ws->nodes[start].label != to[k])
+                    start = NO_NODE;
+                else
+                    start = ws->nodes[start].parent;
+            }
+            if (start == NO_NODE)
+                continue;
+            row[a->end] = std::min(row[a->end],
+                                   ws->row(start)[a->start] + a->edit->weight);
+        }
+    }
+    // deletions only depend on the same row, from left to right
+    auto del = ws->deletions.begin();
+    for (size_t i = 0; i <= n; ++i) {
+        if (i > 0)
+            row[i] = std::min(row[i], row[i - 1] + _deletion_cost);
+        for (; del != ws->deletions.end() && del->end == i; ++del)
+            row[i] = std::min(row[i], row[del->start] + del->edit->weight);
+    }
+}
+
+double LexiconSearch::bound(uint32_t node, Workspace* ws) const {
+    const double* row = ws->row(node);
+    double own = INFINITE;
+    for (size_t i = 0; i < ws->width; ++i)
+        own = std::min(own, row[i] + ws->rest[i]);
+    ws->nodes[node].own_bound = own;
+    // a custom weight with a longer output can still start at one of
+    // the ancestors whose output isn't complete yet
+    double result = own;
+    for (size_t k = 1; k < _max_to && ws->nodes[node].parent != NO_NODE; ++k) {
+        node = ws->nodes[node].parent;
+        result = std::min(result, ws->nodes[node].own_bound);
+    }
+    return result;
+}
+
+void LexiconSearch::expand(uint32_t node, double max_weight,
+                           Workspace* ws) const {
+    const Gfsm::CompiledAcceptor::Tables& t = _dfa->tables();
+    gfsmStateId state = ws->nodes[node].state;
+    for (uint32_t arc = t.offsets[state]; arc < t.offsets[state + 1]; ++arc) {
+        gfsmLabelVal label = t.labels[arc];
+        gfsmStateId target = t.targets[arc];
+        if (label == _boundary && t.finals[target]) {
+            double weight = ws->row(node)[ws->width - 1];
+            if (weight <= max_weight) {
+                ws->heap.push_back(Item{weight, node, true});
+                std::push_heap(ws->heap.begin(), ws->heap.end(), ItemOrder());
+            }
+        }
+        if (t.offsets[target] == t.offsets[target + 1])
+            continue;  // nothing can follow
+        uint32_t child = ws->nodes.size();
+        ws->nodes.push_back(Node{node, target, label, INFINITE});
+        ws->rows.resize(ws->rows.size() + ws->width);
+        fill_row(child, ws);
+        double priority = bound(child, ws);
+        if (priority <= max_weight) {
+            ws->heap.push_back(Item{priority, child, false});
+            std::push_heap(ws->heap.begin(), ws->heap.end(), ItemOrder());
+        } else {  // never expanded, so its space can be reused
+            ws->nodes.pop_back();
+            ws->rows.resize(ws->rows.size() - ws->width);
+        }
+    }
+}
+
+Gfsm::StringPath LexiconSearch::make_path(uint32_t node, double weight,
+                                          const Workspace& ws) const {
+    std::vector<string_impl> output;
+    for (; node != 0; node = ws.nodes[node].parent)
+        output.push_back(_label_symbols[ws.nodes[node].label]);
+    std::reverse(output.begin(), output.end());
+    output.push_back(_label_symbols[_boundary]);
+    return Gfsm::StringPath({}, output, weight);
+}
+}  // namespace WLD
+}  // namespace Normalizer
+}  // namespace Norma
@@ -0,0 +1,118 @@
+/* Copyright 2013-2016 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef NORMALIZER_WLD_LEXICON_SEARCH_H_
+#define NORMALIZER_WLD_LEXICON_SEARCH_H_
+#include<cstdint>
+#include<map>
+#include<memory>
+#include<vector>
+#include"gfsm_wrapper.h"
+#include"string_impl.h"
+#include"normalizer/symbol_table.h"
+
+namespace Norma {
+namespace Normalizer {
+namespace WLD {
+class WeightSet;
+
+/// Finds the closest lexicon words by searching the compiled lexicon.
+/** An alternative to the gfsmxl cascade of WLD: instead of composing a
+ *  weighted edit transducer with the lexicon, the search walks the
+ *  deterministic lexicon automaton directly, best-first, and keeps one
+ *  row of edit distances to the input for every prefix it visits.
+ *
+ *  The edit model is the same as the one compiled into the transducer:
+ *  the default identity, replacement and deletion costs for single
+ *  characters, and the custom weights of the WeightSet, which may
+ *  rewrite sequences of characters. Custom weights whose input isn't a
+ *  sequence of single characters or whose output isn't in the lexicon
+ *  alphabet can never match, so they are left out.
+ *
+ *  A prefix is only expanded while a lower bound on the cost of all
+ *  words starting with it is within the maximum weight, and the words
+ *  are found in order of their cost. This requires non-negative
+ *  weights, which is what training produces.
+ *
+ *  Lookups don't lock anything and reuse per-thread buffers, so one
+ *  object can be shared by any number of threads.
+ **/
+class LexiconSearch {
+ public:
+     /// prepare a search with the given weights
+     /** @param dfa the compiled lexicon, may be nullptr
+      *  @param symbols the lexicon symbols, indexed by label
+      *  @param boundary the label that ends every word
+      **/
+     LexiconSearch(const WeightSet& weights,
+                   std::shared_ptr<const Gfsm::CompiledAcceptor> dfa,
+                   const std::vector<string_impl>& symbols,
+                   gfsmLabelVal boundary);
+     ~LexiconSearch();
+
+     /// false if there is no deterministic lexicon to search
+     bool is_valid() const;
+     /// find the best matching words for a word
+     /** The results are ordered by weight, and their output includes
+      *  the final boundary symbol, just like the results of
+      *  Gfsm::Cascade::lookup_nbest().
+      **/
+     std::vector<Gfsm::StringPath>
+     lookup(const SymbolString& word, const Gfsm::LookupParams& params) const;
+
+ private:
+     /// a custom weight, with the output as lexicon labels
+     struct Edit {
+         std::vector<gfsmLabelVal> to;
+         size_t from_length;
+         double weight;
+     };
+     struct Active;
+     struct Workspace;
+
+     std::shared_ptr<const Gfsm::CompiledAcceptor> _dfa;
+     gfsmLabelVal _boundary;
+     /// lexicon symbols, indexed by label
+     std::vector<string_impl> _label_symbols;
+     /// lexicon labels of the interned characters, 0 if there is none
+     std::vector<gfsmLabelVal> _symbol_labels;
+     double _identity_cost, _replacement_cost, _deletion_cost;
+     /// lower bound for the cost of each input character
+     double _char_cost;
+     /// custom weights by their input
+     std::map<SymbolString, std::vector<Edit>> _edits;
+     /// custom weights without input
+     std::vector<Edit> _insertions;
+     size_t _max_from = 0;
+     size_t _max_to = 0;
+
+     /// collect the custom weights that match somewhere in word
+     void find_active_edits(const SymbolString& word, Workspace* ws) const;
+     /// fill the distance row of a new node
+     void fill_row(uint32_t node, Workspace* ws) const;
+     /// lower bound for all words starting with the prefix of a node
+     double bound(uint32_t node, Workspace* ws) const;
+     /// push the children and the completion of a node
+     void expand(uint32_t node, double max_weight, Workspace* ws) const;
+     Gfsm::StringPath make_path(uint32_t node, double weight,
+                                const Workspace& ws) const;
+};
+}  // namespace WLD
+}  // namespace Normalizer
+}  // namespace Norma
+
+#endif  // NORMALIZER_WLD_LEXICON_SEARCH_H_
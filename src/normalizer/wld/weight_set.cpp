@@ -17,7 +17,9 @@
  */
 #include"weight_set.h"
 #include<algorithm>
+#include<cstdint>
 #include<fstream>
+#include<functional>
 #include<sstream>
 #include<string>
 #include<tuple>
@@ -31,9 +33,18 @@
 namespace Norma {
 namespace Normalizer {
 namespace WLD {
+const WeightSet::SymbolIndex WeightSet::EPS_INDEX;
+const WeightSet::SymbolIndex WeightSet::NO_INDEX;
+
 void WeightSet::clear() {
     _input_symbols.clear();
     _weights.clear();
+    _symbol_indices.clear();
+    _char_indices.clear();
+    _unigrams.assign(1, UnigramWeight());
+    _unigram_rows.clear();
+    _n_rows = 1;
+    _ngrams.clear();
 }
 
 void WeightSet::copy_defaults(const WeightSet& ws) {
@@ -114,7 +125,105 @@ void WeightSet::add_weight(const string_impl& from, const string_impl& to,
 void WeightSet::add_weight(const EditPair& edit, double weight) {
     for (const auto& s : edit.first)
         _input_symbols.insert(s);
-    _weights.insert(std::make_pair(edit, weight));
+    if (!_weights.insert(std::make_pair(edit, weight)).second)
+        return;
+    for (const auto& s : edit.first)
+        intern(s);
+    for (const auto& s : edit.second)
+        intern(s);
+    if (edit.first.size() > 1 || edit.second.size() > 1) {
+        _ngrams[pack(edit)] = weight;
+        return;
+    }
+    SymbolIndex from = edit.first.empty() ? EPS_INDEX
+                                          : unigram_row(edit.first[0]),
+                to   = edit.second.empty() ? EPS_INDEX
+                                           : unigram_row(edit.second[0]);
+    UnigramWeight& w = _unigrams[unigram_cell(from, to)];
+    w.weight = weight;
+    w.is_custom = true;
+}
+
+WeightSet::SymbolIndex WeightSet::find_symbol(const string_impl& symbol)
+                                              const {
+    if (symbol.length() == 1) {
+        SymbolIndex index = _char_indices.get(symbol[0]);
+        return index == 0 ? NO_INDEX : index;
+    }
+    auto it = _symbol_indices.find(symbol);
+    return it == _symbol_indices.end() ? NO_INDEX : it->second;
+}
+
+WeightSet::SymbolIndex WeightSet::intern(const string_impl& symbol) {
+    SymbolIndex index = find_symbol(symbol);
+    if (index != NO_INDEX)
+        return index;
+    index = _symbol_indices.size() + 1;
+    _symbol_indices[symbol] = index;
+    if (symbol.length() == 1)
+        _char_indices[symbol[0]] = index;
+    return index;
+}
+
+WeightSet::SymbolIndex WeightSet::unigram_row(const string_impl& symbol) {
+    SymbolIndex index = intern(symbol);
+    if (index >= _unigram_rows.size())
+        _unigram_rows.resize(index + 1, 0);
+    SymbolIndex& row = _unigram_rows[index];
+    if (row == 0) {
+        row = _n_rows++;
+        _unigrams.resize(static_cast<size_t>(_n_rows) * _n_rows);
+    }
+    return row;
+}
+
+std::vector<WeightSet::SymbolIndex> WeightSet::pack(const EditPair& pair)
+                                                    const {
+    std::vector<SymbolIndex> key;
+    key.reserve(pair.first.size() + pair.second.size() + 1);
+    for (const auto& s : pair.first)
+        key.push_back(find_symbol(s));
+    key.push_back(EPS_INDEX);
+    for (const auto& s : pair.second)
+        key.push_back(find_symbol(s));
+    if (std::find(key.begin(), key.end(), NO_INDEX) != key.end())
+        key.clear();
+    return key;
+}
+
+std::size_t WeightSet::IndexHasher::operator()(
+                          const std::vector<SymbolIndex>& v) const {
+    std::size_t seed = v.size();
+    for (SymbolIndex i : v)
+        seed ^= std::hash<SymbolIndex>()(i)
+                + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+void WeightSet::encode(const std::vector<string_impl>& source,
+                       const std::vector<string_impl>& target,
+                       std::vector<SymbolIndex>* source_indices,
+                       std::vector<SymbolIndex>* target_indices) const {
+    // other symbols are numbered after the rows; there are
+    // only a few of them in a pair, so a linear search will do
+    std::vector<const string_impl*> unknown;
+    auto index = [&](const string_impl& symbol) {
+        SymbolIndex i = find_symbol(symbol);
+        if (i < _unigram_rows.size() && _unigram_rows[i] != 0)
+            return _unigram_rows[i];
+        size_t pos = 0;
+        while (pos < unknown.size() && *unknown[pos] != symbol)
+            ++pos;
+        if (pos == unknown.size())
+            unknown.push_back(&symbol);
+        return static_cast<SymbolIndex>(_n_rows + pos);
+    };  // NOLINT[readability/braces]
+    source_indices->clear();
+    target_indices->clear();
+    for (const auto& s : source)
+        source_indices->push_back(index(s));
+    for (const auto& s : target)
+        target_indices->push_back(index(s));
 }
 
 double WeightSet::get_weight(const string_impl& from,
@@ -123,17 +232,21 @@ double WeightSet::get_weight(const string_impl& from,
 }
 
 double WeightSet::get_weight(const EditPair& pair) const {
-    if (_weights.count(pair) > 0)
-        return _weights.at(pair);
+    if (pair.first.size() <= 1 && pair.second.size() <= 1) {
+        std::vector<SymbolIndex> from, to;
+        encode(pair.first, pair.second, &from, &to);
+        return get_weight(from.empty() ? EPS_INDEX : from[0],
+                          to.empty() ? EPS_INDEX : to[0]);
+    }
+    auto key = pack(pair);
+    if (!key.empty()) {
+        auto it = _ngrams.find(key);
+        if (it != _ngrams.end())
+            return it->second;
+    }
     if (pair.first == pair.second)
         return default_identity_cost() * pair.first.size();
-    if (pair.first.size() > 1 || pair.second.size() > 1)
-        return calculate_wld(pair);
-    if (pair.first.empty())
-        return default_insertion_cost();
-    if (pair.second.empty())
-        return default_deletion_cost();
-    return default_replacement_cost();
+    return calculate_wld(pair);
 }
 
 double WeightSet::calculate_wld(const EditPair& pair) const {
@@ -143,6 +256,10 @@ double WeightSet::calculate_wld(const EditPair& pair) const {
 void WeightSet::divide_all(double divisor) {
     for (auto& elem : _weights)
         elem.second /= divisor;
+    for (auto& elem : _unigrams)
+        elem.weight /= divisor;
+    for (auto& elem : _ngrams)
+        elem.second /= divisor;
 }
 }  // namespace WLD
 }  // namespace Normalizer
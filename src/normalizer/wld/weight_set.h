@@ -17,10 +17,14 @@
  */
 #ifndef NORMALIZER_WLD_WEIGHT_SET_H_
 #define NORMALIZER_WLD_WEIGHT_SET_H_
+#include<algorithm>
+#include<cstdint>
+#include<limits>
 #include<map>
 #include<set>
 #include<string>
 #include<tuple>
+#include<unordered_map>
 #include<vector>
 #include"gfsm_wrapper.h"
 #include"string_impl.h"
@@ -30,8 +34,20 @@
 namespace Norma {
 namespace Normalizer {
 namespace WLD {
+/// Weights of edit operations, with defaults for all other edits.
+/** Besides the map of custom weights, the symbols they contain are
+ *  interned to small indices, so that the Levenshtein algorithm can
+ *  look weights up by index instead of building EditPairs: the weights
+ *  of single symbol edits are kept in a dense matrix, those of longer
+ *  edits in a hash map keyed by the packed indices of the edit.
+ */
 class WeightSet {
  public:
+     /// index of a symbol in this weight set
+     typedef uint32_t SymbolIndex;
+     /// the index of the empty side of an insertion or deletion
+     static const SymbolIndex EPS_INDEX = 0;
+
      void clear();
      bool read_paramfile(const std::string& fname);
      bool save_paramfile(const std::string& fname);
@@ -68,6 +84,27 @@ class WeightSet {
      double get_weight(const EditPair& pair) const;
      void divide_all(double divisor);
 
+     /// get the indices of the source and target symbols of an edit
+     /** The indices are those of the single symbol weights. Symbols
+      *  that aren't part of any of these get indices that are only
+      *  valid for this pair, equal symbols getting the same index.
+      */
+     void encode(const std::vector<string_impl>& source,
+                 const std::vector<string_impl>& target,
+                 std::vector<SymbolIndex>* source_indices,
+                 std::vector<SymbolIndex>* target_indices) const;
+     /// get the weight of replacing one symbol with another
+     /** Either index may be EPS_INDEX for an insertion or deletion.
+      */
+     double get_weight(SymbolIndex from, SymbolIndex to) const {
+         if (std::max(from, to) < _n_rows) {
+             const UnigramWeight& w = _unigrams[unigram_cell(from, to)];
+             if (w.is_custom)
+                 return w.weight;
+         }
+         return get_default_weight(from, to);
+     }
+
  private:
      double _default_identity_cost = 0.0,
          _default_replacement_cost = 1.0,
@@ -80,6 +117,56 @@ class WeightSet {
      /// Set of all used input symbols
      std::set<string_impl> _input_symbols;
 
+     /// Indices of the symbols in custom weights, starting at 1;
+     /// single characters are also indexed by character
+     std::map<string_impl, SymbolIndex> _symbol_indices;
+     DenseCharMap<SymbolIndex> _char_indices;
+     static const SymbolIndex NO_INDEX
+         = std::numeric_limits<SymbolIndex>::max();
+
+     /// Custom weights of single symbol edits, by unigram_cell()
+     struct UnigramWeight {
+         double weight = 0.0;
+         bool is_custom = false;
+     };
+     std::vector<UnigramWeight> _unigrams{UnigramWeight()};
+     /// Rows of the matrix, by symbol index; 0 for symbols that are
+     /// only part of longer edits, row 0 is for EPS_INDEX
+     std::vector<SymbolIndex> _unigram_rows;
+     SymbolIndex _n_rows = 1;
+     /// position of a weight in _unigrams
+     /** The cells whose larger row is m come after those of all smaller
+      *  rows, so a new row and column is added by appending to the
+      *  vector, and it's never larger than needed.
+      */
+     static size_t unigram_cell(SymbolIndex from, SymbolIndex to) {
+         size_t m = std::max(from, to);
+         return m * m + (from == m ? to : m + 1 + from);
+     }
+
+     /// Custom weights of longer edits, by pack()
+     struct IndexHasher {
+         std::size_t operator()(const std::vector<SymbolIndex>& v) const;
+     };
+     std::unordered_map<std::vector<SymbolIndex>, double, IndexHasher>
+         _ngrams;
+
+     SymbolIndex find_symbol(const string_impl& symbol) const;
+     SymbolIndex intern(const string_impl& symbol);
+     /// the row of a symbol, which is added if needed
+     SymbolIndex unigram_row(const string_impl& symbol);
+     /// the indices of the source and target of an edit, separated by
+     /// EPS_INDEX, or an empty vector if a symbol isn't known
+     std::vector<SymbolIndex> pack(const EditPair& pair) const;
+     double get_default_weight(SymbolIndex from, SymbolIndex to) const {
+         if (from == to)
+             return from == EPS_INDEX ? 0.0 : _default_identity_cost;
+         if (from == EPS_INDEX)
+             return _default_insertion_cost;
+         if (to == EPS_INDEX)
+             return _default_deletion_cost;
+         return _default_replacement_cost;
+     }
      double calculate_wld(const EditPair& pair) const;
      static EditPair make_editpair(const string_impl& from,
                                    const string_impl& to);
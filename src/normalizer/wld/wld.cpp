@@ -16,6 +16,7 @@
  * with Norma.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include"wld.h"
+#include<iostream>
 #include<map>
 #include<set>
 #include<string>
@@ -25,7 +26,9 @@
 #include<cmath>
 #include<stdexcept>
 #include"normalizer/cacheable.h"
+#include"normalizer/exceptions.h"
 #include"normalizer/result.h"
+#include"normalizer/symbol_table.h"
 #include"gfsm_wrapper.h"
 #include"string_impl.h"
 #include"interface/iobase.h"
@@ -69,6 +72,13 @@ void WLD::set_from_params(const std::map<std::string, std::string>& params) {
         if (ss >> div)
             set_train_divisor(div);
     }
+    if (params.count(_name + ".train_threads") != 0) {
+        std::stringstream ss;
+        unsigned int n;
+        ss << params.at(_name + ".train_threads");
+        if (ss >> n)
+            set_train_threads(n);
+    }
     if (params.count(_name + ".max_weight") != 0) {
         std::stringstream ss;
         double w;
@@ -83,6 +93,16 @@ void WLD::set_from_params(const std::map<std::string, std::string>& params) {
         if (ss >> ops)
             set_maximum_ops(ops);
     }
+    if (params.count(_name + ".engine") != 0) {
+        const std::string& engine = params.at(_name + ".engine");
+        if (engine == "native")
+            set_engine(Engine::NATIVE);
+        else if (engine == "gfsm")
+            set_engine(Engine::GFSM);
+        else
+            throw init_error("unknown " + _name + ".engine: " + engine);
+    }
+    set_cache_params(_name, params);
 }
 
 WLD::~WLD() {
@@ -104,6 +124,7 @@ void WLD::clear() {
     clear_cache();
     _weights.clear();
     _pairs.clear();
+    _symbol_labels.clear();
     if (_wfst != nullptr) {  // TODO(bollmann): maybe change this to empty init?
         delete _wfst;
         _wfst = nullptr;
@@ -112,6 +133,7 @@ void WLD::clear() {
         delete _cascade;
         _cascade = nullptr;
     }
+    _search.reset();
 }
 
 void WLD::set_lexicon(LexiconInterface* lexicon) {
@@ -124,17 +146,37 @@ void WLD::set_lexicon(LexiconInterface* lexicon) {
 }
 
 Result WLD::do_normalize(const string_impl& word) const {
+    SymbolString symbols;
+    SymbolTable::global().intern(word, &symbols);
+    return do_normalize(word, symbols);
+}
+
+ResultSet WLD::do_normalize(const string_impl& word, unsigned int n) const {
+    if (_search != nullptr) {
+        SymbolString symbols;
+        SymbolTable::global().intern(word, &symbols);
+        return lookup(word, symbols, n);
+    }
+    if (_cascade == nullptr || _gfsm_lex == nullptr)
+        return ResultSet();
+    return lookup(word, _cascade->get_input_alphabet().map_symbols(word), n);
+}
+
+Result WLD::do_normalize(const string_impl& word,
+                         const SymbolString& symbols) const {
     if (is_caching()) {
         Result res = query_cache(word);
         if (res != Result())
             return res;
     }
 
-    ResultSet resultset = this->operator()(word, 1);
-    Result result;
-    if (resultset.size() == 0)
-        result = make_result(word, 0.0);
-    else
+    Result result = make_result(word, 0.0);
+    ResultSet resultset;
+    if (_search != nullptr)
+        resultset = lookup(word, symbols, 1);
+    else if (_cascade != nullptr && _gfsm_lex != nullptr)
+        resultset = lookup(word, map_symbols(symbols), 1);
+    if (resultset.size() > 0)
         result = resultset.front();
 
     if (is_caching())
@@ -143,29 +185,55 @@ Result WLD::do_normalize(const string_impl& word) const {
     return result;
 }
 
-ResultSet WLD::do_normalize(const string_impl& word, unsigned int n) const {
-    if (_cascade == nullptr || _gfsm_lex == nullptr)
-        return ResultSet();
+ResultSet WLD::lookup(const string_impl& word, const Gfsm::LabelVector& labels,
+                      unsigned int n) const {
+    ResultSet resultset;
+    for (const auto& stringpath :
+             _cascade->lookup_nbest_labels(labels,
+                                           make_lookup_params(word, n)))
+        add_result(stringpath, &resultset);
+    return resultset;
+}
 
-    // can't do this in set_maximum_ops because cascade might not exist yet:
+ResultSet WLD::lookup(const string_impl& word, const SymbolString& symbols,
+                      unsigned int n) const {
+    ResultSet resultset;
+    for (const auto& stringpath :
+             _search->lookup(symbols, make_lookup_params(word, n)))
+        add_result(stringpath, &resultset);
+    return resultset;
+}
+
+Gfsm::LookupParams WLD::make_lookup_params(const string_impl& word,
+                                           unsigned int n) const {
+    // the limits are passed with the lookup, so concurrent
+    // lookups don't overwrite each other's limits
+    Gfsm::LookupParams params(n, determine_max_weight(word));
     if (_max_ops > 0)
-        _cascade->set_max_ops(_max_ops);
+        params.max_ops = _max_ops;
+    return params;
+}
 
-    auto results = _cascade->lookup_nbest(word, n, determine_max_weight(word));
-    if (results.size() == 0)
-        return ResultSet();
+void WLD::add_result(const Gfsm::StringPath& path, ResultSet* results) const {
+    std::vector<string_impl> output = path.get_output();
+    strip_boundary_symbol(&output);
+    results->push_back(make_result(Gfsm::implode(output),
+                                   calculate_probability(path.get_weight())));
+    results->back().origin = std::string(name());
+}
 
-    // convert cascade output to Result
-    ResultSet resultset;
-    for (auto stringpath : results) {
-        std::vector<string_impl> output = stringpath.get_output();
-        strip_boundary_symbol(&output);
-        resultset.push_back(
-                   make_result(Gfsm::implode(output),
-                               calculate_probability(stringpath.get_weight())));
-        resultset.back().origin = std::string(name());
+Gfsm::LabelVector WLD::map_symbols(const SymbolString& symbols) const {
+    const Gfsm::Alphabet& alph = _cascade->get_input_alphabet();
+    Gfsm::LabelVector labels;
+    for (SymbolId id : symbols) {
+        gfsmLabelVal label = id < _symbol_labels.size() ? _symbol_labels[id]
+                                                        : 0;
+        // characters not in the alphabet go through the unknown mapper
+        if (label == 0)
+            label = alph.map_char(SymbolTable::global().character(id));
+        labels.push_back(label);
     }
-    return resultset;
+    return labels;
 }
 
 bool WLD::do_train(TrainingData* data) {
@@ -215,10 +283,10 @@ void WLD::compile_transducer() {
         // identity & deletion
         _wfst->add_cyclic_path(StringPath({symi}, {symi}, id_cost), false);
         _wfst->add_cyclic_path(StringPath({symi}, {}, del_cost), false);
-        for (const auto& symo : output_symbols) {  // replacement
-            _wfst->add_cyclic_path(StringPath({symi}, {symo}, rep_cost), false);
-        }
     }
+    // replacement, with one arc per symbol instead of one per pair
+    _wfst->add_cyclic_replacements(input_symbols, output_symbols, rep_cost,
+                                   false);
     // if we compose with the lexicon, final character has to be word boundary
     _wfst->add_path(Gfsm::StringPath({}, {Lexicon::SYMBOL_BOUNDARY}, 0.0));
 }
@@ -228,21 +296,61 @@ void WLD::compile_cascade() {
     _cascade->append(*_wfst);
     _cascade->append(_gfsm_lex);
     _cascade->sort();
+    map_symbol_labels();
+}
+
+void WLD::map_symbol_labels() {
+    _symbol_labels.clear();
+    const Gfsm::Alphabet& alph = _cascade->get_input_alphabet();
+    for (const auto& symbol : alph.covered()) {
+        if (symbol.length() != 1)
+            continue;
+        SymbolId id = SymbolTable::global().intern(symbol[0]);
+        if (id >= _symbol_labels.size())
+            _symbol_labels.resize(id + 1, 0);
+        _symbol_labels[id] = alph.get_label(symbol);
+    }
 }
 
 void WLD::build_gfsm_objects() {
-    if (_wfst != nullptr)
-        delete _wfst;
-    if (_cascade != nullptr)
-        delete _cascade;
+    delete _wfst;
+    delete _cascade;
+    _wfst = nullptr;
+    _cascade = nullptr;
+    _search.reset();
+    _symbol_labels.clear();
     if (!_weights.empty() && _gfsm_lex != nullptr) {
+        if (_engine == Engine::NATIVE) {
+            bool fallback = !build_search();
+            // rebuilding after every training step shouldn't repeat it
+            if (fallback && !_search_fallback)
+                std::cerr << "*** WARNING: " << _name << ".engine=native "
+                          << "needs a deterministic lexicon, using the "
+                          << "gfsm engine instead" << std::endl;
+            _search_fallback = fallback;
+            if (!fallback)
+                return;
+        }
         compile_transducer();
         compile_cascade();
     }
 }
 
+bool WLD::build_search() {
+    std::vector<string_impl> symbols;
+    auto dfa = _gfsm_lex->compiled_acceptor(&symbols);
+    if (dfa == nullptr)
+        return false;
+    _search.reset(new LexiconSearch(_weights, std::move(dfa), symbols,
+                                    _gfsm_lex->get_boundary_label()));
+    if (!_search->is_valid())
+        _search.reset();
+    return _search != nullptr;
+}
+
 bool WLD::perform_training() {
     LevenshteinAligner levenshtein(_weights, _train_ngrams, _train_divisor);
+    levenshtein.threads() = _train_threads;
     unsigned int cycles = 0;
     do {
         levenshtein.perform_training_cycle(_pairs);
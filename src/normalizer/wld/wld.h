@@ -18,13 +18,17 @@
 #ifndef NORMALIZER_WLD_WLD_H_
 #define NORMALIZER_WLD_WLD_H_
 #include<map>
+#include<memory>
 #include<string>
 #include<mutex>
+#include<vector>
 #include"gfsm_wrapper.h"
 #include"string_impl.h"
 #include"normalizer/base.h"
 #include"normalizer/cacheable.h"
 #include"normalizer/result.h"
+#include"normalizer/symbol_table.h"
+#include"lexicon_search.h"
 #include"typedefs.h"
 #include"weight_set.h"
 
@@ -35,6 +39,14 @@ class Lexicon;
 namespace WLD {
 class WLD : public Base, public Cacheable {
  public:
+     /// how candidates are looked up
+     enum class Engine {
+         /// compose an edit transducer with the lexicon using gfsmxl
+         GFSM,
+         /// search the compiled lexicon directly, see LexiconSearch
+         NATIVE
+     };
+
      ~WLD();
      void set_from_params(const std::map<std::string, std::string>& params);
      void init();
@@ -50,6 +62,7 @@ class WLD : public Base, public Cacheable {
          _paramfile = paramfile;
          return *this;
      }
+     std::vector<std::string> param_files() const { return {_paramfile}; }
      /// Get length of n-grams used during training
      unsigned int get_train_ngrams() const { return _train_ngrams; }
      /// Set length of n-grams used during training
@@ -64,6 +77,13 @@ class WLD : public Base, public Cacheable {
          _train_divisor = div;
          return *this;
      }
+     /// Get number of threads used for training (0 = one per hardware thread)
+     unsigned int get_train_threads() const { return _train_threads; }
+     /// Set number of threads used for training (0 = one per hardware thread)
+     WLD& set_train_threads(unsigned int n) {
+         _train_threads = n;
+         return *this;
+     }
      /// Get maximum weight for normalization candidates (0 = no maximum)
      double get_maximum_weight() const { return _max_weight; }
      /// Set maximum weight for normalization candidates (0 = no maximum)
@@ -79,9 +99,20 @@ class WLD : public Base, public Cacheable {
          return *this;
      }
 
+     /// Get the lookup engine
+     Engine get_engine() const { return _engine; }
+     /// Set the lookup engine, takes effect with the next init()
+     WLD& set_engine(Engine engine) {
+         _engine = engine;
+         return *this;
+     }
+
      using Cacheable::set_caching;
      using Cacheable::clear_cache;
      using Cacheable::is_caching;
+     using Cacheable::get_cache_size;
+     using Cacheable::set_cache_size;
+     using Cacheable::cache_stats;
 
      /// trains on learned pairs
      bool perform_training();
@@ -90,7 +121,15 @@ class WLD : public Base, public Cacheable {
      bool do_train(TrainingData* data);
      Result do_normalize(const string_impl& word) const;
      ResultSet do_normalize(const string_impl& word, unsigned int n) const;
+     Result do_normalize(const string_impl& word,
+                         const SymbolString& symbols) const;
      void do_save_params();
+     /// none, training pairs are only collected until the weights are
+     /// learned in perform_training(), and the cascade has its own
+     /// copy of the lexicon
+     WordFilter do_affected_by_training() const {
+         return [](const string_impl&) { return false; };
+     }
 
      Gfsm::StringCascade* _cascade = nullptr;
      Gfsm::StringTransducer* _wfst = nullptr;
@@ -101,16 +140,42 @@ class WLD : public Base, public Cacheable {
      TrainSet _pairs;
      unsigned int _train_ngrams = 3;
      unsigned int _train_divisor = 7;
+     unsigned int _train_threads = 0;
      double _convergence_quota = 0.01;
      unsigned int _max_cycles = 20;
      unsigned int _max_ops = 0;
      double _max_weight = 0.0;
+     Engine _engine = Engine::GFSM;
      Lexicon* _gfsm_lex = nullptr;
+     /// replaces the cascade for lookups if the native engine is used
+     std::unique_ptr<LexiconSearch> _search;
+     /// if the native engine couldn't be used the last time
+     bool _search_fallback = false;
+     /// input labels of the cascade, indexed by SymbolId
+     std::vector<gfsmLabelVal> _symbol_labels;
 
      /// compiles FSTs for lookup
      void build_gfsm_objects();
      void compile_transducer();
      void compile_cascade();
+     void map_symbol_labels();
+     /// sets up the native engine, falls back to the cascade if the
+     /// lexicon can't be searched directly
+     bool build_search();
+
+     /// maps interned symbols to input labels of the cascade
+     Gfsm::LabelVector map_symbols(const SymbolString& symbols) const;
+     /// looks up the n best candidates for word, given as labels
+     ResultSet lookup(const string_impl& word, const Gfsm::LabelVector& labels,
+                      unsigned int n) const;
+     /// looks up the n best candidates for word with the native engine
+     ResultSet lookup(const string_impl& word, const SymbolString& symbols,
+                      unsigned int n) const;
+     /// the limits of a lookup for word
+     Gfsm::LookupParams make_lookup_params(const string_impl& word,
+                                           unsigned int n) const;
+     /// converts a lookup result and appends it to results
+     void add_result(const Gfsm::StringPath& path, ResultSet* results) const;
 
      /// implements maximum weight heuristic (to make lookup faster)
      double determine_max_weight(const string_impl& word) const;
@@ -26,25 +26,38 @@
 #include<utility>
 #include<algorithm>
 #include<future>
-#include<thread>
-#include<chrono>
+#include<iterator>
 #include<iostream>
 #include<sstream>
+#include<vector>
 #include"training_data.h"
 #include"normalizer/exceptions.h"
 #include"lexicon/lexicon.h"
 #include"normalizer/base.h"
+#include"normalizer/symbol_table.h"
+#include"disk_cache.h"
 
 using std::map;
 using std::string;
 
 namespace Norma {
+namespace {
+// mark the pairs that weren't used yet, which are at the end
+void make_new_pairs_used(TrainingData* data) {
+    for (auto pp = data->rbegin(); pp != data->rend(); ++pp) {
+        if (pp->is_used())
+            break;
+        pp->make_used();
+    }
+}
+}  // namespace
 
 PluginSocket::PluginSocket(const string& chain_definition,
                        const string& plugin_base_param,
                        const map<string, string>& params)
     : config_vars(params), chain_def(chain_definition),
       plugin_base(plugin_base_param) {
+    set_caching(false);
     _lex = new Normalizer::Lexicon();
     try {
         _lex->init(params);
@@ -70,6 +83,8 @@ PluginSocket::~PluginSocket() {
 
 void PluginSocket::push_chain(Normalizer::Base* n) {
     push_back(n);
+    detach_disk_cache();
+    invalidate_cache();
 }
 
 void PluginSocket::init_chain() {
@@ -117,12 +132,43 @@ void PluginSocket::init_chain() {
 }
 
 Normalizer::Result PluginSocket::normalize(const string_impl& word) const {
-    // starting all normalizers async seems to make everything slower
-    // presumably this is because the cascade_lookup blocks
+    // the version has to be taken before running the chain, so a
+    // result from before a concurrent train() is never cached as new.
+    // train() detaches the disk cache before changing the version, so
+    // taking the version first also keeps trained results out of it
+    uint64_t version = cache_version();
+    std::shared_ptr<DiskCache> disk = std::atomic_load(&_disk_cache);
+    if (!is_caching() && disk == nullptr)
+        return normalize_chain(word);
+    Normalizer::Result result;
+    if (is_caching()) {
+        result = query_cache(word);
+        if (result != Normalizer::Result())
+            return result;
+    }
+    if (disk == nullptr || !disk->find(word, &result)) {
+        result = normalize_chain(word);
+        // the file is for the untrained chain only
+        if (disk != nullptr && version == cache_version())
+            disk->insert(word, result);
+    }
+    if (is_caching())
+        cache(word, result, version);
+    return result;
+}
+
+Normalizer::Result
+    PluginSocket::normalize_chain(const string_impl& word) const {
+    // normalizers are run one after the other, since the chain
+    // stops at the first one that gives a final result.
+    // parallelism comes from normalizing several words at once.
+    // the word is interned once here and shared by the whole chain.
+    thread_local Normalizer::SymbolString symbols;
+    Normalizer::SymbolTable::global().intern(word, &symbols);
     unsigned int priority = 1;
     Normalizer::Result result, bestresult(word, 0);
     for (auto normalizer : *this) {
-        result = (*normalizer)(word);
+        result = (*normalizer)(word, symbols);
         result.priority = priority;
         bestresult = chooser(&bestresult, &result);
         if (bestresult.is_final)
@@ -135,40 +181,92 @@ Normalizer::Result PluginSocket::normalize(const string_impl& word) const {
 void PluginSocket::train(TrainingData *data) {
     if (data->empty())
         return;
+    // from here on, results differ from those in the disk cache
+    if (has_disk_cache()) {
+        detach_disk_cache();
+        // results that are still being computed mustn't be stored in
+        // it either; this keeps all cached results, since nothing has
+        // changed yet
+        invalidate_cache([](const string_impl&) { return false; });
+    }
 
-    // update the lexicon
-    _lex->add(data->rbegin()->target());
+    // update the lexicon with all pairs that weren't used yet,
+    // there may be more than one when training in batches
+    for (auto pp = data->rbegin(); pp != data->rend(); ++pp) {
+        if (pp->is_used())
+            break;
+        _lex->add(pp->target());
+    }
+    if (empty()) {
+        make_new_pairs_used(data);
+        return;
+    }
 
+    // train all but the first normalizer on their own threads,
+    // and the first one on this thread
     std::list<std::future<bool>> train_done;
-    // start the training threads and detach
-    for (auto normalizer : *this) {
-        std::packaged_task<bool()> train_task([=]() {
-            bool result = normalizer->train(data);
-            return result;
-        });
-        train_done.push_back(train_task.get_future());
-        std::thread(std::move(train_task)).detach();
+    for (auto normalizer = std::next(begin()); normalizer != end();
+         ++normalizer) {
+        Normalizer::Base* n = *normalizer;
+        train_done.push_back(std::async(std::launch::async,
+                                        [n, data]() {
+            return n->train(data);
+        }));
     }
+    front()->train(data);
+    // get() also rethrows exceptions from the training threads
+    for (auto& done : train_done)
+        done.get();
+    // results computed while training may be from either state, but
+    // they only differ for the affected words, which are dropped here.
+    // the chain stops at the first final result, so later normalizers
+    // didn't contribute to it.
+    std::vector<Normalizer::WordFilter> affected;
+    for (auto normalizer : *this)
+        affected.push_back(normalizer->affected_by_training());
+    invalidate_cache_entries([&affected](const string_impl& word,
+                                         const Normalizer::Result& result) {
+        size_t used = result.is_final ? result.priority : affected.size();
+        for (size_t i = 0; i < used && i < affected.size(); ++i) {
+            if (affected[i](word))
+                return true;
+        }
+        return false;
+    });
+    make_new_pairs_used(data);
+}
 
-    // keep querying the futures to see if training is
-    // finished
-    auto pos = train_done.begin();
-    std::future_status status;
-    while (!train_done.empty()) {
-        status = pos->wait_for(std::chrono::milliseconds(5));
-        if (status == std::future_status::ready)
-            pos = train_done.erase(pos);
-        else
-            ++pos;
-        if (pos == train_done.end())
-            pos = train_done.begin();
+uint64_t PluginSocket::fingerprint() const {
+    uint64_t h = DiskCache::hash_bytes(chain_def.data(), chain_def.size(),
+                                       DiskCache::VERSION);
+    const std::string cache_size = ".cache_size";
+    for (const auto& var : config_vars) {
+        // cache sizes don't change any results
+        const std::string& key = var.first;
+        if (key.size() >= cache_size.size()
+            && key.compare(key.size() - cache_size.size(), std::string::npos,
+                           cache_size) == 0)
+            continue;
+        std::string entry = key + "=" + var.second + "\n";
+        h = DiskCache::hash_bytes(entry.data(), entry.size(), h);
     }
-
-    for (auto pp = data->rbegin(); pp != data->rend(); ++pp) {
-        if (pp->is_used())
-            break;
-        pp->make_used();
+    for (const auto& file : _lex->param_files())
+        h = DiskCache::hash_file(file, h);
+    for (auto normalizer : *this) {
+        for (const auto& file : normalizer->param_files())
+            h = DiskCache::hash_file(file, h);
     }
+    return h;
+}
+
+void PluginSocket::attach_disk_cache(const std::string& filename,
+                                     size_t capacity) {
+    std::atomic_store(&_disk_cache, std::make_shared<DiskCache>(
+                                      filename, fingerprint(), capacity));
+}
+
+void PluginSocket::detach_disk_cache() {
+    std::atomic_store(&_disk_cache, std::shared_ptr<DiskCache>());
 }
 
 const Normalizer::Result&
@@ -203,6 +301,8 @@ void PluginSocket::save_params() {
         std::cerr << "*** ERROR: while saving params for Lexicon:"
                   << std::endl << e.what() << std::endl;
     }
+    // normalizers may finish their training when saving
+    invalidate_cache();
 }
 
 Normalizer::Base* PluginSocket::create_plugin(const std::string& lib_name,
@@ -17,13 +17,17 @@
  */
 #ifndef PLUGINSOCKET_H_
 #define PLUGINSOCKET_H_
+#include<cstdint>
 #include<list>
 #include<string>
 #include<map>
+#include<memory>
 #include<functional>
 #include"string_impl.h"
+#include"disk_cache.h"
 #include"normalizer/result.h"
 #include"normalizer/base.h"
+#include"normalizer/cacheable.h"
 
 namespace Norma {
 class TrainingData;
@@ -48,8 +52,16 @@ class Base;
  *  from the Normalizer, and most importantly to hide as many
  *  concurrency related issues as possible from the authors of
  *  the Normalizer.
+ *
+ *  Optionally, the final result of the whole chain can be cached per
+ *  word, so repeated tokens cost only one cache lookup.  The cache is
+ *  off by default; training only invalidates the results of the words
+ *  that the normalizers report as affected, other changes of the chain
+ *  invalidate all of them.  Results can also be kept in a DiskCache file across runs;
+ *  it is detached as soon as the chain is trained.
  **/
-class PluginSocket : private std::list<Normalizer::Base*> {
+class PluginSocket : private std::list<Normalizer::Base*>,
+                     private Normalizer::Cacheable {
  public:
      explicit PluginSocket(const std::string& chain_definition,
                          const std::string& plugin_base_param,
@@ -67,6 +79,9 @@ class PluginSocket : private std::list<Normalizer::Base*> {
      Normalizer::Result normalize(const string_impl& word) const;
      /// start all training in parallel, then wait until
      /// all of them are finished.
+     /** Every normalizer is trained on all pairs of data that aren't
+      *  marked as used yet, which are then marked as used.
+      **/
      void train(TrainingData *data);
      /// choose the result with the best score
      static const Normalizer::Result&
@@ -79,6 +94,28 @@ class PluginSocket : private std::list<Normalizer::Base*> {
      void save_params();
      void init_chain();
 
+     using Normalizer::Cacheable::set_caching;
+     using Normalizer::Cacheable::is_caching;
+     using Normalizer::Cacheable::clear_cache;
+     using Normalizer::Cacheable::get_cache_size;
+     using Normalizer::Cacheable::set_cache_size;
+     using Normalizer::Cacheable::cache_stats;
+
+     /// hash of everything that determines the results of the chain
+     /** Covers the chain definition, the configuration, and the contents
+      *  of all parameter files of the lexicon and the normalizers.
+      **/
+     uint64_t fingerprint() const;
+     /// look up and store results in a DiskCache file
+     /** Throws std::runtime_error if the file can't be used.
+      **/
+     void attach_disk_cache(const std::string& filename,
+                            size_t capacity = DiskCache::DEFAULT_CAPACITY);
+     void detach_disk_cache();
+     bool has_disk_cache() const {
+         return std::atomic_load(&_disk_cache) != nullptr;
+     }
+
      typedef std::function<const Normalizer::Result(Normalizer::Result*,
                                                     Normalizer::Result*)>
              Chooser;
@@ -88,11 +125,16 @@ class PluginSocket : private std::list<Normalizer::Base*> {
  private:
      Normalizer::Base* create_plugin(const std::string& lib_name,
                                      const std::string& alias = "");
+     /// run the chain on a word, without the result cache
+     Normalizer::Result normalize_chain(const string_impl& word) const;
      std::list<std::pair<destroy_t*, Normalizer::Base*>> created_normalizers;
      std::list<void*> loaded_plugins;
      const std::map<std::string, std::string>& config_vars;
      std::string chain_def, plugin_base;
      Normalizer::LexiconInterface* _lex;
+     /// only accessed with std::atomic_load/store, since
+     /// train() may detach it while normalizing
+     std::shared_ptr<DiskCache> _disk_cache;
 };
 }  // namespace Norma
 
@@ -62,6 +62,13 @@ struct rulebased : normalizer_wrapper {
                           "never when determining the n-best candidates. "
                           "It is recommended to always keep this set to True."
                           )
+            .add_property("cache_size",
+                          &Rulebased::get_cache_size, &Rulebased::set_cache_size,
+                          "Maximum number of cached normalization results.\n\n"
+                          "When the cache is full, results for words that are "
+                          "looked up rarely are dropped first.  Set to 0 to "
+                          "make the cache unlimited."
+                          )
             .add_property("rulesfile",
                           bp::make_function(&Rulebased::get_rulesfile,
                               bp::return_value_policy<bp::return_by_value>()),
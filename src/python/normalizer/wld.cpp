@@ -71,6 +71,13 @@ struct wld : normalizer_wrapper {
                           "never when determining the n-best candidates. "
                           "It is recommended to always keep this set to True."
                           )
+            .add_property("cache_size",
+                          &WLD::get_cache_size, &WLD::set_cache_size,
+                          "Maximum number of cached normalization results.\n\n"
+                          "When the cache is full, results for words that are "
+                          "looked up rarely are dropped first.  Set to 0 to "
+                          "make the cache unlimited."
+                          )
             .add_property("ngrams",
                           &WLD::get_train_ngrams,
                           bp::make_function(&WLD::set_train_ngrams,
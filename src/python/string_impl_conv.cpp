@@ -84,6 +84,54 @@ void register_string_impl_converters() {
         boost::python::type_id<string_impl>());
 }
 
+#elif defined(USE_UTF8_STRING)
+
+/// to-python conversion from UTF-8 strings
+PyObject* UTF8String_to_python_str::convert(string_impl const& s) {
+    PyObject* unicode = PyUnicode_DecodeUTF8(s.data(), s.bytes(), "replace");
+    return boost::python::incref(unicode);
+}
+
+/// determine if obj_ptr can be converted to a UTF-8 string
+void* UTF8String_from_python_str::convertible(PyObject* obj_ptr) {
+    if (!PyString_Check(obj_ptr)
+        && !PyUnicode_Check(obj_ptr)) return 0;
+    return obj_ptr;
+}
+
+/// from-python conversion to UTF-8 strings
+void UTF8String_from_python_str::construct(PyObject* obj_ptr,
+                                           py_stage1_data* data) {
+    void* storage = reinterpret_cast<py_storage*>(data)->storage.bytes;
+
+    if (PyUnicode_Check(obj_ptr)) {
+        PyObject* utf8 = PyUnicode_AsUTF8String(obj_ptr);
+        assert(utf8);
+        new (storage) string_impl(PyString_AsString(utf8),
+                                  PyString_Size(utf8));
+        Py_DECREF(utf8);
+    } else {
+        // byte strings are assumed to be UTF-8 already
+        const char* value = PyString_AsString(obj_ptr);
+        assert(value);
+        new (storage) string_impl(value, PyString_Size(obj_ptr));
+    }
+
+    data->convertible = storage;
+}
+
+// register the converters
+void register_string_impl_converters() {
+    boost::python::to_python_converter<
+        string_impl,
+        UTF8String_to_python_str>();
+
+    boost::python::converter::registry::push_back(
+        &UTF8String_from_python_str::convertible,
+        &UTF8String_from_python_str::construct,
+        boost::python::type_id<string_impl>());
+}
+
 #else  // USE_ICU_STRING
 
 /// determine if obj_ptr is a latin1-encodable unicode string
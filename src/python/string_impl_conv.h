@@ -40,6 +40,18 @@ struct ICUString_from_python_str {
                            py_stage1_data* data);
 };
 
+#elif defined(USE_UTF8_STRING)
+
+struct UTF8String_to_python_str {
+    static PyObject* convert(string_impl const& s);
+};
+
+struct UTF8String_from_python_str {
+    static void* convertible(PyObject* obj_ptr);
+    static void  construct(PyObject* obj_ptr,
+                           py_stage1_data* data);
+};
+
 #else  // USE_ICU_STRING
 
 struct STDString_from_python_unicode {
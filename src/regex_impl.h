@@ -21,7 +21,9 @@
 #include<boost/regex.hpp>  // NOLINT[build/include_order]
 #include"defines.h"  // NOLINT[build/include_order]
 
-#ifdef USE_ICU_STRING
+// UTF-8 strings use ICU for character properties, so they
+// can use the Unicode-aware regexes as well
+#if defined(USE_ICU_STRING) || defined(USE_UTF8_STRING)
 #include<boost/regex/icu.hpp>  // NOLINT[build/include_order]
 
 typedef boost::u32regex regex_impl;
@@ -31,7 +33,7 @@ inline regex_impl make_regex_impl(const std::string& regex_str) {
     return boost::make_u32regex(regex_str.c_str());
 }
 
-#else  // USE_ICU_STRING
+#else  // USE_ICU_STRING || USE_UTF8_STRING
 
 typedef boost::regex regex_impl;
 #define REGEX_IMPL_MATCH boost::regex_match
@@ -40,6 +42,6 @@ inline regex_impl make_regex_impl(const std::string& regex_str) {
     return boost::regex(regex_str);
 }
 
-#endif  // USE_ICU_STRING
+#endif  // USE_ICU_STRING || USE_UTF8_STRING
 
 #endif  // REGEX_IMPL_H
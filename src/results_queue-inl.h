@@ -17,7 +17,22 @@
  */
 #ifndef RESULTS_QUEUE_INL_H_
 #define RESULTS_QUEUE_INL_H_
+#include<utility>
 namespace Norma {
+template<typename R>
+constexpr size_t ResultsQueue<R>::default_capacity;
+
+template<typename R>
+ResultsQueue<R>::ResultsQueue(ThreadPool* pool, size_t capacity)
+    : _pool(pool),
+      _ring(capacity == 0 ? default_capacity : capacity) {}
+
+template<typename R>
+ResultsQueue<R>::ResultsQueue(ThreadPool* pool, std::launch policy,
+                              size_t capacity)
+    : _pool(pool), _policy(policy),
+      _ring(capacity == 0 ? default_capacity : capacity) {}
+
 template<typename R>
 void ResultsQueue<R>::set_consumer(std::function<void(R)> consumer) {
     _consumer = consumer;
@@ -28,34 +43,126 @@ void ResultsQueue<R>::set_consumer(std::function<void(R)> consumer) {
 template<typename R>
 void ResultsQueue<R>::add_producer(std::function<R(string_impl)> producer,
                                    const string_impl line) {
-    // TODO(fpetran) set a timeout here maybe in case producer malfunctions?
-    for (; ;) {
-        if (num_threads.load() <= _max_threads)
-            break;
+    add_producer([producer, line]() { return producer(line); });
+}
+
+template<typename R>
+void ResultsQueue<R>::add_producer(std::function<R()> producer) {
+    size_t seq;
+    {
+        std::unique_lock<std::mutex> producer_lock(_mutex);
+        producer_condition.wait(producer_lock, [this] {
+            return _error || _next_seq - _next_out < _ring.size();
+        });
+        if (_error)
+            std::rethrow_exception(_error);
+        seq = _next_seq++;
     }
-    std::unique_lock<std::mutex> consumer_lock(_mutex);
-    results.push(std::async(_policy, producer, line));
-    ++num_threads;
-    if (!output_ready)
-        output_ready = true;
-    consumer_condition.notify_one();
+    if (_pool == nullptr || _policy == std::launch::deferred)
+        store(seq, producer);
+    else  // blocks while the pool's queue is full
+        _pool->post([this, seq, producer]() { store(seq, producer); });
+}
+
+template<typename R>
+void ResultsQueue<R>::store(size_t seq, std::function<R()> producer) {
+    R result;
+    std::exception_ptr error;
+    try {
+        result = producer();
+    } catch(...) {
+        error = std::current_exception();
+    }
+    std::unique_lock<std::mutex> producer_lock(_mutex);
+    Slot& slot = _ring[seq % _ring.size()];
+    slot.result = std::move(result);
+    slot.error = error;
+    slot.ready = true;
+    // notify while locked, finish() may return as soon as it's unlocked.
+    // after an error, finish() is waiting for the remaining producers.
+    if (_error)
+        consumer_condition.notify_all();
+    else if (seq == _next_out)
+        consumer_condition.notify_one();
 }
 
-template<typename R> bool ResultsQueue<R>::consume() {
-    do {
+template<typename R>
+ResultsQueue<R>::~ResultsQueue() {
+    // producers still running on the pool refer to this object
+    wait_all();
+}
+
+template<typename R>
+void ResultsQueue<R>::finish() {
+    wait_all();
+    if (_error)
+        std::rethrow_exception(_error);
+}
+
+template<typename R>
+void ResultsQueue<R>::wait_all() {
+    {
         std::unique_lock<std::mutex> consumer_lock(_mutex);
-        // this loop prevents spurious wakeup
-        while (!output_ready)
-            consumer_condition.wait(consumer_lock,
-                                    [this]{ return output_ready.load(); });
-        while (!results.empty()) {
-            R result = results.front().get();
-            _consumer(result);
-            results.pop();
-            --num_threads;
+        workers_done = true;
+        consumer_condition.notify_all();
+    }
+    if (output_done.valid())
+        output_done.wait();
+    // wait for producers that are still running after an error
+    std::unique_lock<std::mutex> producer_lock(_mutex);
+    consumer_condition.wait(producer_lock, [this] {
+        for (size_t seq = _next_out; seq < _next_seq; ++seq)
+            if (!_ring[seq % _ring.size()].ready)
+                return false;
+        return true;
+    });
+}
+
+template<typename R> void ResultsQueue<R>::consume() {
+    std::vector<R> done;
+    std::unique_lock<std::mutex> consumer_lock(_mutex);
+    for (; ;) {
+        // the predicate also guards against spurious wakeup
+        consumer_condition.wait(consumer_lock, [this] {
+            return _ring[_next_out % _ring.size()].ready
+                || (workers_done && _next_out == _next_seq);
+        });
+        // take the whole contiguous run of finished results
+        bool failed = false;
+        for (; ;) {
+            Slot& slot = _ring[_next_out % _ring.size()];
+            if (!slot.ready)
+                break;
+            slot.ready = false;
+            ++_next_out;
+            if (slot.error) {
+                _error = slot.error;
+                slot.error = nullptr;
+                failed = true;
+                break;
+            }
+            done.push_back(std::move(slot.result));
+        }
+        producer_condition.notify_all();
+        if (done.empty() && !failed)  // all producers are done
+            return;
+        // don't hold the lock while consuming, or producers would block
+        consumer_lock.unlock();
+        try {
+            for (R& result : done)
+                _consumer(std::move(result));
+        } catch(...) {
+            consumer_lock.lock();
+            if (!_error)
+                _error = std::current_exception();
+            producer_condition.notify_all();
+            return;
         }
-    } while (!workers_done);
-    return true;
+        done.clear();
+        consumer_lock.lock();
+        if (failed)
+            return;
+    }
 }
 }  // namespace Norma
 #endif  // RESULTS_QUEUE_INL_H_
@@ -17,60 +17,80 @@
  */
 #ifndef RESULTS_QUEUE_H_
 #define RESULTS_QUEUE_H_
-#include<queue>
+#include<vector>
 #include<thread>
 #include<future>
+#include<mutex>
 #include<condition_variable>
+#include<exception>
 #include<functional>
 #include"string_impl.h"
+#include"thread_pool.h"
 
 namespace Norma {
 /// a multi producer-single consumer queue
 /**
+ * producers are run on the workers of a ThreadPool, which is shared by all
+ * lines, so no threads are created per line.
+ *
+ * every producer gets a sequence number, and its result is stored in a
+ * fixed-size ring at that position as soon as it is done. the consumer
+ * takes results from the ring in sequence order, so a slow producer only
+ * holds up the results behind it from being consumed, not from being
+ * computed. add_producer() blocks while the ring is full, which keeps
+ * memory bounded no matter how long the input is.
+ *
  * policy only relates to the producer threads, the consumer is always async.
- * if max_threads is 0, it will be set to hardware_concurrency (the number of
- * threads that can physically be executed in parallel).
+ * if policy is std::launch::deferred, or no pool is given, the producers
+ * are run synchronously in add_producer().
+ *
+ * if a producer throws, the exception is passed on by finish() and by
+ * any following add_producer() call.
  **/
 template<typename RESULT_TY> class ResultsQueue {
  public:
-     ResultsQueue() { init(); }
-     explicit ResultsQueue(unsigned max_threads) { init(max_threads); }
-     explicit ResultsQueue(std::launch policy) { init(0, policy); }
-     ResultsQueue(unsigned max_threads, std::launch policy) {
-         init(max_threads, policy);
-     }
+     /// capacity is the size of the ring, 0 means the default
+     explicit ResultsQueue(ThreadPool* pool, size_t capacity = 0);
+     ResultsQueue(ThreadPool* pool, std::launch policy, size_t capacity = 0);
+     ResultsQueue(const ResultsQueue& a) = delete;
+     const ResultsQueue& operator=(const ResultsQueue& a) = delete;
+     /// waits for all running producers
+     ~ResultsQueue();
      void set_consumer(std::function<void(RESULT_TY)> consumer);
      void add_producer(std::function<RESULT_TY(string_impl)> producer,
                        const string_impl line);
+     /// queue a producer that brings its own input
+     void add_producer(std::function<RESULT_TY()> producer);
      /// consume remaining results and wait for the consumer to be done
-     void finish() {
-         output_ready = true;
-         workers_done = true;
-         consumer_condition.notify_all();
-         output_done.wait();
-     }
+     void finish();
+
+     static constexpr size_t default_capacity = 4096;
 
  private:
+     /// a position in the ring
+     struct Slot {
+         RESULT_TY result;
+         std::exception_ptr error;
+         bool ready = false;
+     };
+     void store(size_t seq, std::function<RESULT_TY()> producer);
+     void consume();
+     void wait_all();
+
+     ThreadPool* _pool;
      std::launch _policy = std::launch::async|std::launch::deferred;
-     unsigned _max_threads;
-     std::atomic<unsigned> num_threads{0};
      std::mutex _mutex;
      std::function<void(RESULT_TY)> _consumer;
-     std::queue<std::future<RESULT_TY>> results;
-     std::future<bool> output_done;
-     std::atomic<bool> output_ready{false}, workers_done{false};
-     std::condition_variable consumer_condition;
-
-     void init(unsigned max_threads = 0,
-               std::launch policy = std::launch::async|std::launch::deferred) {
-         if (max_threads == 0)
-             _max_threads = std::thread::hardware_concurrency() * 2;
-         _policy = policy;
-     }
-     bool consume();
+     std::vector<Slot> _ring;
+     /// sequence number of the next producer, and of the next
+     /// result to be consumed
+     size_t _next_seq = 0, _next_out = 0;
+     std::exception_ptr _error;
+     std::future<void> output_done;
+     bool workers_done = false;
+     std::condition_variable consumer_condition, producer_condition;
 };
 }  // namespace Norma
 
 #include"results_queue-inl.h"
 #endif  // NORMA_RESULTS_QUEUE_H_
-
@@ -21,17 +21,15 @@
 #include<string>
 #include<istream>
 #include<ostream>
+#include<unicode/bytestream.h>  // NOLINT[build/include_order]
 
 const char* to_cstr(const string_impl& str) {
-    // one problem with this function:
-    // it returns a char ptr, so if i call it
-    // twice, both char ptr will have the value
-    // of the second call. might be fixable by
-    // making the ptr non static, but idk what
-    // that will do to performance.
-    thread_local char out[256];
-    out[str.extract(0, 99, out)] = 0;
-    return out;
+    // the buffer keeps its capacity, so this only allocates
+    // when a longer string than before comes along
+    thread_local std::string out;
+    out.clear();
+    str.toUTF8String(out);
+    return out.c_str();
 }
 
 std::istream& operator>>(std::istream& strm, string_impl& val) {
@@ -42,9 +40,23 @@ std::istream& operator>>(std::istream& strm, string_impl& val) {
     return strm;
 }
 
+namespace {
+/// passes converted bytes straight on to a stream
+class OStreamByteSink : public icu::ByteSink {
+ public:
+     explicit OStreamByteSink(std::ostream* strm) : _strm(strm) {}
+     void Append(const char* bytes, int32_t n) {
+         _strm->write(bytes, n);
+     }
+
+ private:
+     std::ostream* _strm;
+};
+}  // namespace
+
 std::ostream& operator<<(std::ostream& strm, const string_impl& ustr) {
-    std::string str = to_cstr(ustr);
-    strm << str;
+    OStreamByteSink sink(&strm);
+    ustr.toUTF8(sink);
     return strm;
 }
 
@@ -18,14 +18,19 @@
 //
 // All string implementation stuff goes here. Provides
 // wrapper for all operations and queries related to strings
-// so that the actual code has the option of using std::string
-// as well as UCI strings.
+// so that the actual code has the option of using std::string,
+// ICU strings, or our own UTF-8 strings.
 #ifndef STRING_IMPL_H_
 #define STRING_IMPL_H_
 #include"defines.h"  // NOLINT[build/include_order]
+#include<cstddef>
+#include<type_traits>
+#include<unordered_map>
+#include<vector>
 
 #ifdef USE_ICU_STRING
 #include<istream>
+#include<string>
 #include<ostream>
 #include<unicode/unistr.h> // NOLINT[build/include_order]
 #include<unicode/uchar.h>  // NOLINT[build/include_order]
@@ -67,6 +72,7 @@ inline bool check_if_alpha(char_impl c) {
     return u_isalpha(c);
 }
 
+/// UTF-8 version of str, valid until the next call in the same thread
 const char* to_cstr(const string_impl&);
 
 inline string_impl from_char(char_impl c) {
@@ -77,9 +83,69 @@ inline bool is_empty(const string_impl& str) {
     return str.isEmpty();
 }
 
+inline string_impl from_utf8(const char* str, size_t len) {
+    return UnicodeString::fromUTF8(StringPiece(str, len));
+}
+
+inline std::string to_utf8(const string_impl& str) {
+    std::string out;
+    str.toUTF8String(out);
+    return out;
+}
+
+/// append str as UTF-8 to out
+inline void append_utf8(const string_impl& str, std::string* out) {
+    str.toUTF8String(*out);
+}
+
 std::istream& operator>>(std::istream& strm, string_impl& val);
 std::ostream& operator<<(std::ostream& strm, const string_impl& ustr);
 
+#elif defined(USE_UTF8_STRING)
+#include<string>
+#include<unicode/uchar.h>  // NOLINT[build/include_order]
+#include"utf8_string.h"
+
+typedef utf8_string_impl string_impl;
+typedef char32_t char_impl;
+typedef size_t string_size;
+
+static const size_t string_npos = utf8_string_impl::npos;
+
+inline void extract(const string_impl& str, int from, int to, string_impl* out)
+    { str.extract(from, to, out); }
+
+inline string_size string_find(const string_impl& me, const char* you)
+    { return me.find(you); }
+
+inline bool check_if_alpha(char_impl c) {
+    return u_isalpha(c);
+}
+
+inline const char* to_cstr(const string_impl& str) {
+    return str.c_str();
+}
+
+inline string_impl from_char(char_impl c) {
+    return c;
+}
+
+inline bool is_empty(const string_impl& str) {
+    return str.empty();
+}
+
+inline string_impl from_utf8(const char* str, size_t len) {
+    return string_impl(str, len);
+}
+
+inline std::string to_utf8(const string_impl& str) {
+    return str.str();
+}
+
+inline void append_utf8(const string_impl& str, std::string* out) {
+    out->append(str.data(), str.bytes());
+}
+
 #else  // USE_ICU_STRING
 #include<algorithm>
 #include<string>
@@ -92,7 +158,7 @@ typedef size_t string_size;
 static const size_t string_npos = std::string::npos;
 
 inline void extract(const string_impl& str, int from, int to, string_impl* out)
-    { *out = str.substr(from, to); }
+    { out->assign(str, from, to - from); }
 
 inline string_size string_find(const string_impl& me, const char* you)
     { return me.find(you); }
@@ -106,22 +172,95 @@ inline const char* to_cstr(const string_impl& str) {
 }
 
 inline string_impl from_char(char_impl c) {
-    std::stringstream ss;
-    std::string s;
-    ss << c;
-    ss >> s;
-    return s;
+    return string_impl(1, c);
 }
 
 inline bool is_empty(const string_impl& str) {
     return str.empty();
 }
 
+inline string_impl from_utf8(const char* str, size_t len) {
+    return string_impl(str, len);
+}
+
+inline std::string to_utf8(const string_impl& str) {
+    return str;
+}
+
+inline void append_utf8(const string_impl& str, std::string* out) {
+    out->append(str);
+}
+
 #endif  // USE_ICU_STRING
 
 void extract_tail(const string_impl& str, string_size len, string_impl* out);
 
 bool has_alpha(const string_impl& str);
 
+/// Maps characters to values, e.g. labels or IDs
+/** Characters of the Basic Multilingual Plane are looked up in a
+ *  vector indexed by their code, the others in a hash map. The vector
+ *  only grows as far as the largest character stored, except for
+ *  values that can't be copied, like atomics: those can't be moved to
+ *  a bigger vector, so it gets its full size from the start, and
+ *  slots of the vector can then be used while others are stored.
+ **/
+template<typename T>
+class DenseCharMap {
+ public:
+     static const size_t DENSE_CHARS = 0x10000;
+     static const bool GROWS = std::is_copy_constructible<T>::value;
+
+     DenseCharMap() : _dense(GROWS ? 0 : DENSE_CHARS) {}
+
+     static size_t index(char_impl c) {
+         return static_cast<typename std::make_unsigned<char_impl>::type>(c);
+     }
+     /// true if c is stored in the vector
+     static bool is_dense(char_impl c) { return index(c) < DENSE_CHARS; }
+
+     /// the slot of c, or nullptr if it has none yet
+     /** Slots hold T() until something is stored in them. */
+     const T* slot(char_impl c) const {
+         size_t idx = index(c);
+         if (idx < _dense.size())
+             return &_dense[idx];
+         if (idx < DENSE_CHARS)
+             return nullptr;
+         auto it = _wide.find(idx);
+         return it == _wide.end() ? nullptr : &it->second;
+     }
+     /// remove all values, only for maps that grow
+     void clear() {
+         static_assert(GROWS, "the vector has to keep its full size");
+         _dense.clear();
+         _wide.clear();
+     }
+     /// the value of c, or T() if none was stored
+     T get(char_impl c) const {
+         const T* value = slot(c);
+         return value == nullptr ? T() : *value;
+     }
+     /// the slot of c, which is created if needed
+     T& operator[](char_impl c) {
+         size_t idx = index(c);
+         if (idx >= DENSE_CHARS)
+             return _wide[idx];
+         if (idx >= _dense.size())
+             grow(idx + 1, std::integral_constant<bool, GROWS>());
+         return _dense[idx];
+     }
+
+ private:
+     void grow(size_t size, std::true_type) { _dense.resize(size); }
+     void grow(size_t, std::false_type) {}
+
+     std::vector<T> _dense;
+     std::unordered_map<size_t, T> _wide;
+};
+
+template<typename T> const size_t DenseCharMap<T>::DENSE_CHARS;
+template<typename T> const bool DenseCharMap<T>::GROWS;
+
 #endif  // STRING_IMPL_H_
 
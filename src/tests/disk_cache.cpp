@@ -0,0 +1,179 @@
+/* Copyright 2013-2016 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE DiskCache
+#include<fstream>
+#include<string>
+#include<utility>
+#include<vector>
+#include<boost/filesystem.hpp>  // NOLINT[build/include_order]
+#include<boost/test/included/unit_test.hpp>  // NOLINT[build/include_order]
+#include"disk_cache.h"
+#include"normalizer/result.h"
+#include"string_impl.h"
+
+namespace fs = boost::filesystem;
+using Norma::DiskCache;
+using Norma::Normalizer::Result;
+using Norma::Normalizer::LogLevel;
+
+struct DiskCacheFixture {
+    const fs::path file = fs::temp_directory_path() / fs::unique_path();
+    ~DiskCacheFixture() {
+        fs::remove(file);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(DiskCache1, DiskCacheFixture)
+
+BOOST_AUTO_TEST_CASE(disk_cache_insert_find) {
+    DiskCache cache(file.string(), 42, 1 << 20);
+    BOOST_CHECK_EQUAL(cache.fingerprint(), 42);
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+    Result result("und", 0.75, "WLD"), found;
+    result.priority = 3;
+    result.messages.push(Norma::Normalizer::make_message(
+                             LogLevel::TRACE, "WLD", "no candidate found"));
+    BOOST_CHECK(!cache.find("vnnd", &found));
+    BOOST_CHECK(cache.insert("vnnd", result));
+    BOOST_CHECK(!cache.insert("vnnd", result));
+    BOOST_CHECK_EQUAL(cache.size(), 1);
+    BOOST_REQUIRE(cache.find("vnnd", &found));
+    BOOST_CHECK_EQUAL(found.word, "und");
+    BOOST_CHECK_EQUAL(found.score, 0.75);
+    BOOST_CHECK_EQUAL(found.origin, "WLD");
+    BOOST_CHECK_EQUAL(found.priority, 3);
+    BOOST_REQUIRE_EQUAL(found.messages.size(), 1);
+    BOOST_CHECK(found.messages.front() == result.messages.front());
+    BOOST_CHECK(!cache.find("vnd", &found));
+    BOOST_CHECK(cache.insert("naß", Result("nass", 0.5, "Mapper")));
+    BOOST_REQUIRE(cache.find("naß", &found));
+    BOOST_CHECK_EQUAL(found.word, "nass");
+}
+
+BOOST_AUTO_TEST_CASE(disk_cache_reopen) {
+    {
+        DiskCache cache(file.string(), 42, 1 << 20);
+        for (int i = 0; i < 1000; ++i) {
+            std::string word = "w" + std::to_string(i);
+            cache.insert(word.c_str(), Result(word.c_str(), 1.0));
+        }
+    }
+    DiskCache cache(file.string(), 42, 1 << 20);
+    BOOST_CHECK_EQUAL(cache.size(), 1000);
+    Result found;
+    for (int i = 0; i < 1000; ++i) {
+        std::string word = "w" + std::to_string(i);
+        BOOST_REQUIRE(cache.find(word.c_str(), &found));
+        BOOST_CHECK_EQUAL(found.word, word.c_str());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(disk_cache_shared) {
+    DiskCache one(file.string(), 42, 1 << 20),
+              two(file.string(), 42, 1 << 20);
+    Result found;
+    one.insert("vnnd", Result("und", 1.0));
+    BOOST_REQUIRE(two.find("vnnd", &found));
+    BOOST_CHECK_EQUAL(found.word, "und");
+    BOOST_CHECK(!two.insert("vnnd", Result("und", 1.0)));
+}
+
+BOOST_AUTO_TEST_CASE(disk_cache_fingerprint_mismatch) {
+    DiskCache old(file.string(), 42, 1 << 20);
+    old.insert("vnnd", Result("und", 1.0));
+    DiskCache cache(file.string(), 43, 1 << 20);
+    Result found;
+    BOOST_CHECK_EQUAL(cache.fingerprint(), 43);
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+    BOOST_CHECK(!cache.find("vnnd", &found));
+    // the old file stays usable for whoever still has it open
+    BOOST_CHECK(old.find("vnnd", &found));
+}
+
+BOOST_AUTO_TEST_CASE(disk_cache_invalid_file) {
+    {
+        std::ofstream out(file.string());
+        out << "not a cache file";
+    }
+    DiskCache cache(file.string(), 42, 1 << 20);
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+    BOOST_CHECK(cache.insert("vnnd", Result("und", 1.0)));
+}
+
+BOOST_AUTO_TEST_CASE(disk_cache_damaged_header) {
+    // header fields: magic, version, byte order, fingerprint, file
+    // size, n_buckets, data, used, entries
+    const size_t n_buckets_pos = 32, data_pos = 40, used_pos = 48;
+    std::vector<std::pair<size_t, uint64_t>> damages = {
+        {n_buckets_pos, 0}, {n_buckets_pos, 1000}, {n_buckets_pos, 1 << 30},
+        {data_pos, 8}, {data_pos, 2 << 20}, {used_pos, 8}, {used_pos, 2 << 20}
+    };
+    for (const auto& damage : damages) {
+        {
+            DiskCache cache(file.string(), 42, 1 << 20);
+            cache.insert("vnnd", Result("und", 1.0));
+        }
+        {
+            std::fstream f(file.string(),
+                           std::ios::binary | std::ios::in | std::ios::out);
+            f.seekp(damage.first);
+            f.write(reinterpret_cast<const char*>(&damage.second),
+                    sizeof(damage.second));
+        }
+        DiskCache cache(file.string(), 42, 1 << 20);
+        Result found;
+        BOOST_CHECK_EQUAL(cache.size(), 0);
+        BOOST_CHECK(!cache.find("vnnd", &found));
+        BOOST_CHECK(cache.insert("vnnd", Result("und", 1.0)));
+        BOOST_CHECK(cache.find("vnnd", &found));
+        fs::remove(file);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(disk_cache_full) {
+    DiskCache cache(file.string(), 42, 8192);
+    int inserted = 0;
+    for (int i = 0; i < 1000; ++i) {
+        std::string word = "w" + std::to_string(i);
+        if (cache.insert(word.c_str(), Result(word.c_str(), 1.0)))
+            ++inserted;
+    }
+    BOOST_CHECK_GT(inserted, 0);
+    BOOST_CHECK_LT(inserted, 1000);
+    BOOST_CHECK_EQUAL(cache.size(), inserted);
+    BOOST_CHECK_EQUAL(fs::file_size(file), 8192);
+}
+
+BOOST_AUTO_TEST_CASE(disk_cache_hash_file) {
+    {
+        std::ofstream out(file.string());
+        out << "v\tu\t0.5\n";
+    }
+    uint64_t h = DiskCache::hash_file(file.string(), 0);
+    BOOST_CHECK_EQUAL(h, DiskCache::hash_file(file.string(), 0));
+    BOOST_CHECK_NE(h, DiskCache::hash_file(file.string(), 1));
+    {
+        std::ofstream out(file.string());
+        out << "v\tu\t0.4\n";
+    }
+    BOOST_CHECK_NE(h, DiskCache::hash_file(file.string(), 0));
+    BOOST_CHECK_NE(h, DiskCache::hash_file(file.string() + ".missing", 0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -17,8 +17,10 @@
  */
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE Gfsm_Wrapper
+#include<algorithm>
 #include<map>
 #include<string>
+#include<future>
 #include<iostream>
 #include<stdexcept>
 #include<set>
@@ -216,6 +218,23 @@ BOOST_AUTO_TEST_CASE(map_symbols2) {
     BOOST_CHECK_EQUAL(vec.get(2), 20);
 }
 
+BOOST_AUTO_TEST_CASE(map_symbols_buffer) {
+    gfsmLabelVal labels[4];
+    BOOST_REQUIRE_EQUAL(alph.map_symbols("unda", labels), 4);
+    BOOST_CHECK_EQUAL(labels[0], 44);
+    BOOST_CHECK_EQUAL(labels[1], 43);
+    BOOST_CHECK_EQUAL(labels[2], 42);
+    BOOST_CHECK_EQUAL(labels[3], 0);  // "a" is unknown
+    alph.set_ignore_unknowns(true);
+    BOOST_REQUIRE_EQUAL(alph.map_symbols("aua", labels), 1);
+    BOOST_CHECK_EQUAL(labels[0], 44);
+    // characters added later are found as well
+    alph.add_mapping("a", 101);
+    BOOST_CHECK_EQUAL(alph.map_char('a'), 101);
+    BOOST_REQUIRE_EQUAL(alph.map_symbols("aua", labels), 3);
+    BOOST_CHECK_EQUAL(labels[2], 101);
+}
+
 BOOST_AUTO_TEST_CASE(add_symbol) {
     BOOST_CHECK(!alph.contains("ä"));
     BOOST_CHECK_EQUAL(alph.add_symbol("ä"), 45);
@@ -384,6 +403,58 @@ BOOST_AUTO_TEST_CASE(accepts) {
     BOOST_CHECK(!fsm->accepts(invalid_labels));
 }
 
+BOOST_AUTO_TEST_CASE(compiled_accepts) {
+    CompiledAcceptor dfa(*fsm);
+    BOOST_REQUIRE(dfa.is_valid());
+    BOOST_CHECK(dfa.accepts(eins));
+    BOOST_CHECK(dfa.accepts(zwei));
+    BOOST_CHECK(dfa.accepts(zweite));
+    BOOST_CHECK(dfa.accepts(zwei_term));
+    BOOST_CHECK(!dfa.accepts(zweite_term));
+    BOOST_CHECK(!dfa.accepts(invalid_labels));
+    // the compiled copy doesn't see later changes
+    fsm->add_path(zweite_term);
+    BOOST_CHECK(!dfa.accepts(zweite_term));
+    BOOST_CHECK(CompiledAcceptor(*fsm).accepts(zweite_term));
+}
+
+BOOST_AUTO_TEST_CASE(builder_minimal) {
+    AcceptorBuilder builder;
+    BOOST_CHECK(builder.add({3, 1, 5, 7}));
+    BOOST_CHECK(builder.add({4, 2, 6, 7}));
+    BOOST_CHECK(builder.add({9, 1, 5, 7}));
+    BOOST_CHECK(!builder.add({9, 1, 5, 7}));
+    CompiledAcceptor dfa = builder.finish();
+    BOOST_REQUIRE(dfa.is_valid());
+    BOOST_CHECK_EQUAL(dfa.root(), 0);
+    // the paths for 3 and 9 are merged, so are the last two states
+    BOOST_CHECK_EQUAL(dfa.tables().n_states, 7);
+    BOOST_CHECK_EQUAL(dfa.step(0, 3), dfa.step(0, 9));
+    Acceptor copy;
+    dfa.to_acceptor(&copy);
+    BOOST_CHECK(copy.accepts(LabelVector({4, 2, 6, 7})));
+    BOOST_CHECK(copy.accepts(LabelVector({9, 1, 5, 7})));
+    BOOST_CHECK(!copy.accepts(LabelVector({9, 1, 5})));
+    BOOST_CHECK(!copy.accepts(LabelVector({4, 1, 5, 7})));
+}
+
+BOOST_AUTO_TEST_CASE(builder_partials) {
+    AcceptorBuilder builder;
+    builder.add({1, 2}, true);
+    builder.add({1, 3}, true);
+    CompiledAcceptor dfa = builder.finish();
+    BOOST_CHECK(dfa.accepts(LabelVector({1})));
+    BOOST_CHECK(dfa.accepts(LabelVector({1, 3})));
+    BOOST_CHECK(!dfa.accepts(LabelVector()));
+}
+
+BOOST_AUTO_TEST_CASE(builder_unsorted) {
+    AcceptorBuilder builder;
+    builder.add({1, 2});
+    builder.add({3});
+    BOOST_CHECK_THROW(builder.add({1, 3}), std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_CASE(accepted) {
     std::set<LabelVector> a = fsm->accepted();
     BOOST_CHECK(a.count(eins) > 0);
@@ -647,6 +718,34 @@ BOOST_AUTO_TEST_CASE(transducer_add_cyclic_paths_multiple) {
     BOOST_CHECK_EQUAL(expected.size(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(transducer_add_cyclic_replacements) {
+    fsm->add_cyclic_path(Path(n, n, 0.0));
+    fsm->add_cyclic_path(Path(d, d, 0.0));
+    fsm->add_cyclic_replacements(LabelVector {4, 6}, LabelVector {8, 9}, 0.5);
+    // v -> u|s, n -> n, d -> d|u|s
+    std::vector<Path> expected {Path(vnd, und, 0.5),
+                                Path(vnd, LabelVector {9, 5, 6}, 0.5),
+                                Path(vnd, LabelVector {8, 5, 8}, 1.0),
+                                Path(vnd, uns, 1.0),
+                                Path(vnd, LabelVector {9, 5, 8}, 1.0),
+                                Path(vnd, LabelVector {9, 5, 9}, 1.0)};
+    std::set<Path> results = fsm->transduce(vnd);
+    BOOST_REQUIRE_EQUAL(results.size(), expected.size());
+    for (const Path& p : results) {
+        BOOST_CHECK(p.get_input() == vnd);
+        auto match = std::find_if(expected.begin(), expected.end(),
+                                  [&p](const Path& e) {
+                                      return e.get_output() == p.get_output();
+                                  });
+        BOOST_REQUIRE(match != expected.end());
+        BOOST_CHECK_CLOSE(match->get_weight(), p.get_weight(), 0.0001);
+        expected.erase(match);
+    }
+    // nothing to replace with
+    fsm->add_cyclic_replacements(LabelVector {5}, LabelVector {}, 0.1);
+    BOOST_CHECK_EQUAL(fsm->transduce(vnd).size(), 6);
+}
+
 BOOST_AUTO_TEST_CASE(transducer_add_nonfinal) {
     fsm->add_path(Path(v, u, 0.5), false, false);
     std::set<Path> results = fsm->transduce(v);
@@ -944,6 +1043,40 @@ BOOST_AUTO_TEST_CASE(cascade_lookup_best_paths_weight_cutoff) {
     BOOST_CHECK_CLOSE((*it).get_weight(), 0.3, 0.0001);
 }
 
+BOOST_AUTO_TEST_CASE(cascade_lookup_params) {
+    csc->set_max_paths(1);
+    csc->set_max_weight(10.0);
+    std::set<Path> results = csc->lookup_nbest(vec_in, LookupParams(10, 10.0));
+    BOOST_CHECK_EQUAL(results.size(), 2);
+    // the stored limits are left alone
+    BOOST_CHECK_EQUAL(csc->get_max_paths(), 1);
+    results = csc->lookup_nbest(vec_in, LookupParams(10, 0.5));
+    BOOST_CHECK_EQUAL(results.size(), 1);
+    BOOST_CHECK_EQUAL(csc->lookup_nbest(vec_in).size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(cascade_lookup_parallel) {
+    csc->set_max_paths(1);
+    csc->set_max_weight(10.0);
+    auto lookup = [this](const LabelVector& in) {
+        std::vector<std::set<Path>> results;
+        for (int i = 0; i < 200; ++i)
+            results.push_back(csc->lookup_nbest(in));
+        return results;
+    };
+    std::vector<std::future<std::vector<std::set<Path>>>> futures;
+    for (int t = 0; t < 4; ++t)
+        futures.push_back(std::async(std::launch::async, lookup,
+                                     t % 2 ? vec_in : triple_in));
+    for (int t = 0; t < 4; ++t) {
+        const LabelVector& best = t % 2 ? vec_best : triple_best;
+        for (const std::set<Path>& result : futures[t].get()) {
+            BOOST_REQUIRE_EQUAL(result.size(), 1);
+            BOOST_CHECK(result.begin()->get_output() == best);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 ///////////////////// StringCascade //////////////////////
@@ -89,14 +89,26 @@ BOOST_AUTO_TEST_CASE(NormalOutputTest) {
     {
         cout_redirect guard(test_stdout.rdbuf());
         output->put_line(&res, false, Norma::Normalizer::LogLevel::SILENT);
+        output->flush();
     }
     BOOST_CHECK(test_stdout.is_equal("foo\n"));
 
     {
         cout_redirect guard(test_stdout.rdbuf());
         output->put_line(&res, true, Norma::Normalizer::LogLevel::SILENT);
+        output->flush();
     }
     BOOST_CHECK(test_stdout.is_equal("foo\t0.5\n"));
+
+    // lines are buffered until flushed
+    {
+        cout_redirect guard(test_stdout.rdbuf());
+        output->put_line(&res, false, Norma::Normalizer::LogLevel::SILENT);
+        output->put_line(&res, true, Norma::Normalizer::LogLevel::SILENT);
+        BOOST_CHECK(test_stdout.is_empty());
+        output->flush();
+    }
+    BOOST_CHECK(test_stdout.is_equal("foo\nfoo\t0.5\n"));
 }
 
 BOOST_AUTO_TEST_CASE(FileInputTest) {
@@ -125,5 +137,34 @@ BOOST_AUTO_TEST_CASE(FileInputTest) {
     BOOST_CHECK(input->request_quit());
 }
 
+BOOST_AUTO_TEST_CASE(MappedFileInputTest) {
+    BOOST_CHECK_THROW(Norma::MappedFileInput("fakefile.txt"),
+                      std::runtime_error);
+
+    input = new Norma::MappedFileInput(std::string(TEST_BASE_DIR)
+                                     + "/fileinput.txt");
+    output = new Norma::Output();
+    input->initialize(c, output, tdata);
+    output->initialize(c, input, tdata);
+
+    BOOST_REQUIRE(input->thread_suitable());
+    BOOST_CHECK(input->stable_lines());
+    boost::string_ref first = input->get_raw_line();
+    BOOST_CHECK_EQUAL(first, "foo");
+    BOOST_CHECK_EQUAL(input->get_line(), "foobar");
+    BOOST_CHECK(!input->request_train());
+    BOOST_CHECK_EQUAL(input->get_line(), "bar\tbaz");
+    BOOST_CHECK(input->request_train());
+    BOOST_CHECK_EQUAL(input->get_line(), "anshelmus\tanselm");
+    BOOST_CHECK(input->request_train());
+    BOOST_CHECK_EQUAL(input->get_line(), "bla");
+    BOOST_CHECK(!input->request_train());
+    // the input ends with a newline, so there is no empty last line
+    BOOST_CHECK(input->request_quit());
+    BOOST_CHECK_EQUAL(input->get_line(), "");
+    // earlier lines stay valid
+    BOOST_CHECK_EQUAL(first, "foo");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,172 @@
+/* Copyright 2013-2016 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Normalizer_Cacheable
+#include<atomic>
+#include<map>
+#include<string>
+#include<thread>
+#include<vector>
+#include<boost/test/included/unit_test.hpp>  // NOLINT[build/include_order]
+#include"normalizer/cacheable.h"
+#include"normalizer/result.h"
+#include"string_impl.h"
+
+using Norma::Normalizer::Cacheable;
+using Norma::Normalizer::CacheStats;
+using Norma::Normalizer::Result;
+
+struct TestCache : public Cacheable {
+    using Cacheable::query_cache;
+    using Cacheable::cache;
+    using Cacheable::set_cache_params;
+};
+
+string_impl make_word(const std::string& prefix, int n) {
+    return string_impl((prefix + std::to_string(n)).c_str());
+}
+
+BOOST_AUTO_TEST_SUITE(Cacheable1)
+
+BOOST_AUTO_TEST_CASE(cache_query) {
+    TestCache c;
+    BOOST_CHECK(c.query_cache("vnnd") == Result());
+    c.cache("vnnd", Result("und", 0.5));
+    BOOST_CHECK(c.query_cache("vnnd") == Result("und", 0.5));
+    c.cache("vnnd", Result("und", 0.75));
+    BOOST_CHECK(c.query_cache("vnnd") == Result("und", 0.75));
+    CacheStats stats = c.cache_stats();
+    BOOST_CHECK_EQUAL(stats.hits, 2);
+    BOOST_CHECK_EQUAL(stats.misses, 1);
+    BOOST_CHECK_EQUAL(stats.entries, 1);
+    c.clear_cache();
+    BOOST_CHECK(c.query_cache("vnnd") == Result());
+    BOOST_CHECK_EQUAL(c.cache_stats().entries, 0);
+}
+
+BOOST_AUTO_TEST_CASE(cache_invalidate) {
+    TestCache c;
+    c.cache("vnnd", Result("und", 0.5));
+    uint64_t version = c.cache_version();
+    c.invalidate_cache();
+    BOOST_CHECK_GT(c.cache_version(), version);
+    BOOST_CHECK(c.query_cache("vnnd") == Result());
+    BOOST_CHECK_EQUAL(c.cache_stats().entries, 0);
+    // results computed before the invalidation are not stored
+    c.cache("vnnd", Result("und", 0.5), version);
+    BOOST_CHECK(c.query_cache("vnnd") == Result());
+    c.cache("vnnd", Result("und", 0.75), c.cache_version());
+    BOOST_CHECK(c.query_cache("vnnd") == Result("und", 0.75));
+}
+
+BOOST_AUTO_TEST_CASE(cache_invalidate_selected) {
+    TestCache c;
+    c.cache("vnnd", Result("und", 0.5));
+    c.cache("jn", Result("in", 0.5));
+    uint64_t version = c.cache_version();
+    c.invalidate_cache([](const string_impl& word) { return word == "jn"; });
+    BOOST_CHECK_GT(c.cache_version(), version);
+    BOOST_CHECK(c.query_cache("vnnd") == Result("und", 0.5));
+    BOOST_CHECK(c.query_cache("jn") == Result());
+    BOOST_CHECK_EQUAL(c.cache_stats().entries, 1);
+    // unaffected results computed before are still not stored, since
+    // they can't be told apart from affected ones anymore
+    c.cache("jn", Result("in", 0.5), version);
+    BOOST_CHECK(c.query_cache("jn") == Result());
+    // entries that were outdated already stay outdated
+    c.invalidate_cache();
+    c.invalidate_cache([](const string_impl&) { return false; });
+    BOOST_CHECK(c.query_cache("vnnd") == Result());
+}
+
+BOOST_AUTO_TEST_CASE(cache_size_params) {
+    TestCache c;
+    BOOST_CHECK_EQUAL(c.get_cache_size(), Cacheable::DEFAULT_CACHE_SIZE);
+    std::map<std::string, std::string> params;
+    params["WLD.cache_size"] = "250";
+    params["Other.cache_size"] = "10";
+    c.set_cache_params("WLD", params);
+    BOOST_CHECK_EQUAL(c.get_cache_size(), 250);
+    params["WLD.cache_size"] = "many";
+    c.set_cache_params("WLD", params);
+    BOOST_CHECK_EQUAL(c.get_cache_size(), 250);
+}
+
+BOOST_AUTO_TEST_CASE(cache_bounded) {
+    TestCache c;
+    c.set_cache_size(64);
+    for (int i = 0; i < 2000; ++i) {
+        string_impl word = make_word("w", i);
+        c.query_cache(word);
+        c.cache(word, Result(word, 1.0));
+    }
+    CacheStats stats = c.cache_stats();
+    BOOST_CHECK_LE(stats.entries, 64);
+    BOOST_CHECK_GT(stats.entries, 0);
+    BOOST_CHECK_EQUAL(stats.misses, 2000);
+    BOOST_CHECK_EQUAL(stats.evictions + stats.rejections + stats.entries,
+                      2000);
+    // shrinking evicts the surplus
+    c.set_cache_size(16);
+    BOOST_CHECK_LE(c.cache_stats().entries, 16);
+    // and 0 means no limit
+    c.set_cache_size(0);
+    for (int i = 0; i < 2000; ++i)
+        c.cache(make_word("v", i), Result("v", 1.0));
+    BOOST_CHECK_GE(c.cache_stats().entries, 2000);
+}
+
+BOOST_AUTO_TEST_CASE(cache_keeps_frequent_words) {
+    TestCache c;
+    c.set_cache_size(16);
+    c.query_cache("hot");
+    c.cache("hot", Result("hat", 0.5));
+    for (int i = 0; i < 5000; ++i) {
+        BOOST_REQUIRE(c.query_cache("hot") == Result("hat", 0.5));
+        string_impl rare = make_word("rare", i);
+        if (c.query_cache(rare) == Result())
+            c.cache(rare, Result(rare, 1.0));
+    }
+    BOOST_CHECK_GT(c.cache_stats().rejections, 0);
+}
+
+BOOST_AUTO_TEST_CASE(cache_concurrent) {
+    TestCache c;
+    c.set_cache_size(100);
+    std::atomic<int> wrong {0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+        threads.emplace_back([&c, &wrong, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                string_impl word = make_word("w", (i * 7 + t) % 300);
+                Result res = c.query_cache(word);
+                if (res == Result())
+                    c.cache(word, Result(word, 1.0));
+                else if (res.word != word)
+                    ++wrong;
+            }
+        });
+    for (auto& t : threads)
+        t.join();
+    BOOST_CHECK_EQUAL(wrong.load(), 0);
+    CacheStats stats = c.cache_stats();
+    BOOST_CHECK_EQUAL(stats.hits + stats.misses, 8000);
+    BOOST_CHECK_LE(stats.entries, 112);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
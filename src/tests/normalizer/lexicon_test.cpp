@@ -18,6 +18,9 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE Normalizer_Lexicon
 #include<algorithm>
+#include<cstring>
+#include<fstream>
+#include<iterator>
 #include<map>
 #include<stdexcept>
 #include<string>
@@ -25,6 +28,7 @@
 #include<iostream>
 #include<vector>
 #include<boost/test/included/unit_test.hpp>  // NOLINT[build/include_order]
+#include<boost/filesystem.hpp>  // NOLINT[build/include_order]
 #include"gfsmlibs.h"
 #include"config.h"
 #include"mock_lexicon.h"
@@ -103,6 +107,28 @@ BOOST_AUTO_TEST_CASE(lexicon_contains) {
     BOOST_CHECK(lex.contains("zweitens"));
 }
 
+BOOST_AUTO_TEST_CASE(lexicon_cursor) {
+    Lexicon::Cursor c = lex.cursor();
+    BOOST_CHECK(c.is_valid());
+    BOOST_CHECK(!c.is_final());
+    BOOST_CHECK(c.advance("zw"));
+    Lexicon::Cursor copy = c;
+    BOOST_CHECK(c.advance("ei"));
+    BOOST_CHECK(c.is_final());
+    BOOST_CHECK(c.advance("t"));
+    BOOST_CHECK(!c.is_final());
+    BOOST_CHECK(c.advance("ens"));
+    BOOST_CHECK(c.is_final());
+    BOOST_CHECK(!c.advance("x"));
+    BOOST_CHECK(!c.is_valid());
+    BOOST_CHECK(!c.is_final());
+    // copies are independent
+    BOOST_CHECK(!copy.advance("a"));
+    BOOST_CHECK(!copy.is_valid());
+    BOOST_CHECK(lex.cursor().advance("eins"));
+    BOOST_CHECK(!lex.cursor().advance("zwa"));
+}
+
 BOOST_AUTO_TEST_CASE(lexicon_add_word) {
     BOOST_REQUIRE(!lex.contains("zweite"));
     lex.add("zweite");
@@ -116,6 +142,42 @@ BOOST_AUTO_TEST_CASE(lexicon_add_word) {
     BOOST_CHECK(lex.contains_partial("naß"));
 }
 
+BOOST_AUTO_TEST_CASE(lexicon_cursor_during_add) {
+    Lexicon::Cursor c = lex.cursor();
+    BOOST_REQUIRE(c.advance("zw"));
+    lex.add("zwanzig");
+    lex.add("dreißig");
+    // rebuilds the compiled lexicon
+    BOOST_REQUIRE(lex.compiled_acceptor() != nullptr);
+    Lexicon::Cursor copy = c;
+    BOOST_CHECK(c.advance("ei"));
+    BOOST_CHECK(c.is_final());
+    BOOST_CHECK(c.advance("tens"));
+    BOOST_CHECK(c.is_final());
+    BOOST_CHECK(!copy.advance("x"));
+    BOOST_CHECK(lex.cursor().advance("zwanzig"));
+}
+
+BOOST_AUTO_TEST_CASE(lexicon_add_word_interleaved) {
+    // lookups between the additions may or may not use the compiled
+    // table, but have to see every word added so far
+    std::vector<string_impl> words = {"drei", "dreizehn", "vier", "vierte",
+                                      "dreißig", "fünf", "zehn", "vierzehn"};
+    for (size_t i = 0; i < words.size(); ++i) {
+        BOOST_REQUIRE(!lex.contains(words[i]));
+        lex.add(words[i]);
+        for (size_t j = 0; j <= i; ++j) {
+            BOOST_CHECK(lex.contains(words[j]));
+            BOOST_CHECK(lex.contains_partial(words[j]));
+            Lexicon::Cursor c = lex.cursor();
+            BOOST_CHECK(c.advance(words[j]));
+            BOOST_CHECK(c.is_final());
+        }
+        BOOST_CHECK(lex.contains("zwei"));
+        BOOST_CHECK(!lex.contains("zweite"));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(lexicon_entries) {
     std::vector<string_impl> ls = lex.entries();
     BOOST_CHECK(std::count(ls.begin(), ls.end(), "eins") > 0);
@@ -138,6 +200,111 @@ BOOST_AUTO_TEST_CASE(lexicon_size) {
     BOOST_CHECK_EQUAL(entries.size(), 12);
 }
 
+BOOST_AUTO_TEST_CASE(lexicon_entry_iterator) {
+    std::vector<string_impl> expected = lex.entries(), streamed;
+    auto it = lex.entry_iterator();
+    string_impl word;
+    while (it->next(&word))
+        streamed.push_back(word);
+    BOOST_CHECK(!it->next(&word));
+    std::sort(expected.begin(), expected.end());
+    std::sort(streamed.begin(), streamed.end());
+    BOOST_CHECK(expected == streamed);
+    BOOST_CHECK_EQUAL(streamed.size(), 12);
+    lex.add("zweite");
+    lex.add("zweite");
+    BOOST_CHECK_EQUAL(lex.size(), 13);
+    lex.add("zwei und");
+    BOOST_CHECK_EQUAL(lex.size(), lex.entries().size());
+}
+
+BOOST_AUTO_TEST_CASE(lexicon_image) {
+    namespace fs = boost::filesystem;
+    const fs::path image = fs::temp_directory_path() / fs::unique_path();
+    lex.optimize();
+    lex.save_image(image.string());
+    BOOST_REQUIRE(Norma::Normalizer::LexiconImage::is_image(image.string()));
+    BOOST_CHECK(!Norma::Normalizer::LexiconImage::is_image(TEST_FSMFILE));
+
+    Lexicon mapped;
+    mapped.set_lexfile(image.string());
+    mapped.init();
+    BOOST_CHECK(mapped.contains("eins"));
+    BOOST_CHECK(mapped.contains("zweitens"));
+    BOOST_CHECK(!mapped.contains("zweite"));
+    BOOST_CHECK(mapped.contains_partial("zwe"));
+    BOOST_CHECK(!mapped.contains_partial("zwa"));
+    BOOST_CHECK(mapped.cursor().advance("zwei"));
+    BOOST_CHECK_EQUAL(mapped.size(), 12);
+    // adding words builds the automaton from the image
+    mapped.add("naß");
+    BOOST_CHECK(mapped.contains("naß"));
+    BOOST_CHECK(mapped.contains("eins"));
+    fs::remove(image);
+}
+
+BOOST_AUTO_TEST_CASE(lexicon_image_non_ascii) {
+    namespace fs = boost::filesystem;
+    const fs::path image = fs::temp_directory_path() / fs::unique_path();
+    lex.add("naß");
+    lex.add("über");
+    lex.optimize();
+    lex.save_image(image.string());
+
+    Lexicon mapped;
+    mapped.set_lexfile(image.string());
+    mapped.init();
+    BOOST_CHECK(mapped.contains("naß"));
+    BOOST_CHECK(mapped.contains("über"));
+    BOOST_CHECK(mapped.contains_partial("üb"));
+    BOOST_CHECK(!mapped.contains("nas"));
+    BOOST_CHECK(!mapped.contains("uber"));
+    fs::remove(image);
+}
+
+BOOST_AUTO_TEST_CASE(lexicon_image_corrupt) {
+    namespace fs = boost::filesystem;
+    const fs::path image = fs::temp_directory_path() / fs::unique_path();
+    lex.optimize();
+    lex.save_image(image.string());
+    std::string contents;
+    {
+        std::ifstream in(image.string(), std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(in),
+                        std::istreambuf_iterator<char>());
+    }
+    // header fields after the magic: version, byte order, n_states,
+    // n_arcs, root, n_symbols, ...
+    const size_t n_symbols_pos = 8 + 5 * sizeof(uint32_t);
+    auto write_with = [&](size_t pos, uint32_t value) {
+        std::string corrupt = contents;
+        memcpy(&corrupt[pos], &value, sizeof(value));
+        std::ofstream out(image.string(), std::ios::binary | std::ios::trunc);
+        out << corrupt;
+    };
+    // more symbols than the file has room for
+    write_with(n_symbols_pos, 0x10000000);
+    BOOST_CHECK_THROW(Norma::Normalizer::LexiconImage(image.string()),
+                      Norma::Normalizer::init_error);
+    // more arcs than the file has room for
+    write_with(8 + 3 * sizeof(uint32_t), 0x10000000);
+    BOOST_CHECK_THROW(Norma::Normalizer::LexiconImage(image.string()),
+                      Norma::Normalizer::init_error);
+    // an arc to a state that doesn't exist; the section offsets come
+    // after the 32 bit fields: offsets, labels, targets, ...
+    uint64_t targets_pos;
+    memcpy(&targets_pos, &contents[48 + 2 * sizeof(uint64_t)],
+           sizeof(targets_pos));
+    uint32_t target;
+    memcpy(&target, &contents[targets_pos], sizeof(target));
+    write_with(targets_pos, 0xfffffff0);
+    BOOST_CHECK_THROW(Norma::Normalizer::LexiconImage(image.string()),
+                      Norma::Normalizer::init_error);
+    write_with(targets_pos, target);
+    BOOST_CHECK_NO_THROW(Norma::Normalizer::LexiconImage(image.string()));
+    fs::remove(image);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 struct Lexicon3Fixture {
@@ -161,6 +328,27 @@ BOOST_AUTO_TEST_CASE(lexicon_add_from_scratch) {
     BOOST_CHECK(!lex.contains("a"));
 }
 
+BOOST_AUTO_TEST_CASE(lexicon_build_sorted) {
+    std::vector<string_impl> words {"eins", "zwei", "zweitens", "zwo"};
+    Norma::Normalizer::LexiconInterface::VectorEntryIterator it(words);
+    lex.build(&it);
+    BOOST_CHECK_EQUAL(lex.size(), 4);
+    BOOST_CHECK(lex.contains("zwei"));
+    BOOST_CHECK(lex.contains("zweitens"));
+    BOOST_CHECK(!lex.contains("zweit"));
+    BOOST_CHECK(lex.contains_partial("zweit"));
+    lex.add("drei");
+    BOOST_CHECK(lex.contains("drei"));
+    BOOST_CHECK_EQUAL(lex.size(), 5);
+    BOOST_CHECK_EQUAL(lex.entries().size(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(lexicon_build_unsorted) {
+    std::vector<string_impl> words {"zwei", "eins", "zwo"};
+    Norma::Normalizer::LexiconInterface::VectorEntryIterator it(words);
+    BOOST_CHECK_THROW(lex.build(&it), std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_CASE(non_existant_filename) {
     lex.set_lexfile("<dummy>");
     lex.set_symfile("<dummy>");
@@ -213,6 +401,16 @@ BOOST_AUTO_TEST_CASE(mock_lexicon_contains_partial) {
     BOOST_CHECK(!lex.contains_partial("a"));
 }
 
+BOOST_AUTO_TEST_CASE(mock_lexicon_cursor) {
+    MockLexicon::Cursor c = lex.cursor();
+    BOOST_CHECK(c.advance("e"));
+    BOOST_CHECK(c.advance("in"));
+    BOOST_CHECK(!c.is_final());
+    BOOST_CHECK(c.advance("s"));
+    BOOST_CHECK(c.is_final());
+    BOOST_CHECK(!c.advance("e"));
+}
+
 BOOST_AUTO_TEST_CASE(mock_lexicon_contains) {
     BOOST_CHECK(lex.contains("eins"));
     BOOST_CHECK(lex.contains("zwei"));
@@ -26,6 +26,7 @@
 #include"normalizer/exceptions.h"
 #include"normalizer/mapper.h"
 #include"normalizer/result.h"
+#include"training_data.h"
 
 using Norma::Normalizer::Mapper::Mapper;
 using Norma::Normalizer::Result;
@@ -130,6 +131,15 @@ BOOST_AUTO_TEST_CASE(normalizer_clear) {
     BOOST_CHECK_EQUAL(after.score, 0);
 }
 
+BOOST_AUTO_TEST_CASE(mapper_affected_by_training) {
+    Norma::TrainingData data;
+    data.add_pair("vnd", "und");
+    m->train(&data);
+    auto affected = m->affected_by_training();
+    BOOST_CHECK(affected("vnd"));
+    BOOST_CHECK(!affected("jn"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(Mapper2)
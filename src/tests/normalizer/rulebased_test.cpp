@@ -31,6 +31,7 @@
 #include"normalizer/exceptions.h"
 #include"normalizer/rulebased.h"
 #include"normalizer/rulebased/symbols.h"
+#include"training_data.h"
 
 using namespace Norma::Normalizer::Rulebased;  // NOLINT[build/namespaces]
 using Norma::Normalizer::Result;
@@ -549,6 +550,35 @@ BOOST_AUTO_TEST_CASE(rulebased_normalize_n_best) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(rulebased_affected_by_training) {
+    (*r)("vnd");
+    (*r)("fvo");
+    Norma::TrainingData data;
+    data.add_pair("vnd", "und");
+    r->train(&data);
+    // this changes the average rule frequency
+    BOOST_CHECK(r->affected_by_training()("fvo"));
+
+    data.rbegin()->make_used();
+    data.add_pair("vnd", "und");
+    r->train(&data);
+    auto affected = r->affected_by_training();
+    BOOST_CHECK(affected("vnd"));
+    // none of the rules learned from vnd apply anywhere in fvo
+    BOOST_CHECK(!affected("fvo"));
+    // words that weren't normalized before can't be checked
+    BOOST_CHECK(affected("zwo"));
+
+    // nothing new to train on
+    data.rbegin()->make_used();
+    r->train(&data);
+    BOOST_CHECK(!r->affected_by_training()("vnd"));
+    // new lexicon entries can be the result for any word
+    lex->add("zwo");
+    r->train(&data);
+    BOOST_CHECK(r->affected_by_training()("fvo"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(Rulebased2)
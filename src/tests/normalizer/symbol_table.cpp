@@ -0,0 +1,87 @@
+/* Copyright 2013-2016 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Normalizer_SymbolTable
+#include<set>
+#include<thread>
+#include<vector>
+#include<boost/test/included/unit_test.hpp>  // NOLINT[build/include_order]
+#include"normalizer/symbol_table.h"
+#include"string_impl.h"
+
+using Norma::Normalizer::SymbolId;
+using Norma::Normalizer::SymbolString;
+using Norma::Normalizer::SymbolTable;
+
+BOOST_AUTO_TEST_SUITE(SymbolTable1)
+
+BOOST_AUTO_TEST_CASE(intern_word) {
+    SymbolTable table;
+    SymbolString symbols;
+    table.intern("anna", &symbols);
+    BOOST_REQUIRE_EQUAL(symbols.size(), 4);
+    BOOST_CHECK_EQUAL(symbols[0], 1);
+    BOOST_CHECK_EQUAL(symbols[1], 2);
+    BOOST_CHECK_EQUAL(symbols[2], 2);
+    BOOST_CHECK_EQUAL(symbols[3], 1);
+    BOOST_CHECK_EQUAL(table.size(), 2);
+    BOOST_CHECK(table.character(1) == string_impl("a")[0]);
+    BOOST_CHECK(table.character(2) == string_impl("n")[0]);
+    BOOST_CHECK_THROW(table.character(SymbolTable::NO_SYMBOL),
+                      std::out_of_range);
+    BOOST_CHECK_THROW(table.character(3), std::out_of_range);
+    // the buffer is reused
+    table.intern("na", &symbols);
+    BOOST_REQUIRE_EQUAL(symbols.size(), 2);
+    BOOST_CHECK_EQUAL(symbols[0], 2);
+    BOOST_CHECK_EQUAL(symbols[1], 1);
+    table.intern("", &symbols);
+    BOOST_CHECK(symbols.empty());
+}
+
+BOOST_AUTO_TEST_CASE(find_symbol) {
+    SymbolTable table;
+    string_impl word = "xy";
+    BOOST_CHECK_EQUAL(table.find(word[0]), SymbolTable::NO_SYMBOL);
+    SymbolId x = table.intern(word[0]);
+    BOOST_CHECK_EQUAL(table.find(word[0]), x);
+    BOOST_CHECK_EQUAL(table.find(word[1]), SymbolTable::NO_SYMBOL);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_intern) {
+    SymbolTable table;
+    string_impl word = "abcdefghijklmnopqrstuvwxyz";
+    std::vector<SymbolString> results(8);
+    std::vector<std::thread> threads;
+    for (auto& result : results)
+        threads.emplace_back([&table, &word, &result]() {
+            for (int i = 0; i < 100; ++i)
+                table.intern(word, &result);
+        });
+    for (auto& t : threads)
+        t.join();
+    BOOST_CHECK_EQUAL(table.size(), word.length());
+    std::set<SymbolId> ids(results[0].begin(), results[0].end());
+    BOOST_CHECK_EQUAL(ids.size(), word.length());
+    for (const auto& result : results)
+        BOOST_CHECK(result == results[0]);
+    for (size_t i = 0; i < results[0].size(); ++i)
+        BOOST_CHECK(table.character(results[0][i]) == word[i]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
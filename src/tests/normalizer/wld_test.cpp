@@ -19,6 +19,7 @@
 #define BOOST_TEST_MODULE Normalizer_WLD
 #include<algorithm>
 #include<initializer_list>
+#include<limits>
 #include<map>
 #include<set>
 #include<string>
@@ -28,6 +29,7 @@
 #include"normalizer/exceptions.h"
 #include"lexicon/lexicon.h"
 #include"normalizer/result.h"
+#include"normalizer/symbol_table.h"
 #include"normalizer/wld.h"
 #include"normalizer/wld/levenshtein_algorithm.h"
 #include"normalizer/wld/levenshtein_aligner.h"
@@ -45,6 +47,8 @@ const std::string TEST_WEIGHTSFILE =
     std::string(TEST_BASE_DIR) + "/test-weights.txt";
 const std::string TEST_MALFORMED_WEIGHTSFILE =
     std::string(TEST_BASE_DIR) + "/test-weights-malformed.txt";
+const std::string TEST_ALIGNER_WEIGHTSFILE =
+    std::string(TEST_BASE_DIR) + "/test-aligner-weights.txt";
 
 //////// WeightSet /////////////////////////////////////////////////////////////
 
@@ -143,6 +147,50 @@ BOOST_AUTO_TEST_CASE(ws_input_symbols) {
     BOOST_CHECK(symbols == expected);
 }
 
+BOOST_AUTO_TEST_CASE(ws_symbol_indices) {
+    // enough symbols to make the weight matrix grow
+    string_impl letters("abcdefghijklmnopqrstuvwxyz");
+    for (string_size i = 0; i + 1 < letters.length(); ++i)
+        ws.add_weight(from_char(letters[i]), from_char(letters[i+1]),
+                      0.01 * (i + 1));
+    ws.add_weight("a", "b", 0.9);  // doesn't replace the first weight
+    ws.add_weight("ab", "c", 0.3);
+    ws.default_replacement_cost() = 0.7;
+    ws.default_insertion_cost() = 0.8;
+    ws.divide_all(2.0);
+    for (string_size i = 0; i + 1 < letters.length(); ++i)
+        BOOST_CHECK_CLOSE(ws.get_weight(from_char(letters[i]),
+                                        from_char(letters[i+1])),
+                          0.005 * (i + 1), 0.0001);
+    BOOST_CHECK_CLOSE(ws.get_weight("ab", "c"), 0.15, 0.0001);
+    // defaults are looked up when used, not when the weights are added
+    BOOST_CHECK_CLOSE(ws.get_weight("b", "a"), 0.7, 0.0001);
+    BOOST_CHECK_CLOSE(ws.get_weight(Symbols::EPS, "1"), 0.8, 0.0001);
+
+    std::vector<WeightSet::SymbolIndex> source, target;
+    ws.encode({"a", "ä", "ö"}, {"ö", "a", "1"}, &source, &target);
+    BOOST_REQUIRE_EQUAL(source.size(), 3);
+    BOOST_REQUIRE_EQUAL(target.size(), 3);
+    BOOST_CHECK_EQUAL(source[0], target[1]);
+    BOOST_CHECK_EQUAL(source[2], target[0]);
+    BOOST_CHECK(source[1] != target[0] && source[1] != target[2]);
+    BOOST_CHECK_EQUAL(ws.get_weight(source[2], target[0]),
+                      ws.default_identity_cost());
+    BOOST_CHECK_CLOSE(ws.get_weight(source[1], target[2]), 0.7, 0.0001);
+    BOOST_CHECK_CLOSE(ws.get_weight(source[0], WeightSet::EPS_INDEX),
+                      ws.default_deletion_cost(), 0.0001);
+
+    // symbols of longer edits only don't get a row of the matrix,
+    // so they are numbered like unknown ones
+    ws.add_weight("üß", "ÿ", 0.4);
+    std::vector<WeightSet::SymbolIndex> source2, target2;
+    ws.encode({"ü"}, {"ÿ"}, &source, &target);
+    ws.encode({"ñ"}, {"ü"}, &source2, &target2);
+    BOOST_CHECK_EQUAL(source[0], source2[0]);
+    BOOST_CHECK_EQUAL(target[0], target2[0]);
+    BOOST_CHECK_CLOSE(ws.get_weight(source[0], target[0]), 0.7, 0.0001);
+}
+
 BOOST_AUTO_TEST_CASE(ws_read_paramfile) {
     ws.read_paramfile(TEST_WEIGHTSFILE);
     BOOST_REQUIRE_EQUAL(ws.size(), 6);
@@ -164,6 +212,53 @@ BOOST_AUTO_TEST_SUITE_END()
 
 //////// LevenshteinAlgorithm //////////////////////////////////////////////////
 
+// the alignments as the set-based implementation computed them,
+// with a full AlignmentSet in every cell of the distance matrix
+AlignmentSet set_based_align(const WordPair& p, const WeightSet& ws) {
+    auto source = Gfsm::explode(p.first), target = Gfsm::explode(p.second);
+    size_t tlen = target.size();
+    std::vector<double> this_row(tlen + 1), next_row(tlen + 1);
+    std::vector<AlignmentSet> this_edit(tlen + 1), next_edit(tlen + 1);
+    auto extended = [](RuleSet rs, const EditPair& ep) {
+        rs.push_back(ep);
+        return rs;
+    };  // NOLINT[readability/braces]
+    this_row[0] = 0;
+    this_edit[0] = {RuleSet()};
+    for (size_t t = 0; t < tlen; ++t) {
+        EditPair ins({}, {target[t]});
+        this_row[t+1] = this_row[t] + ws.get_weight(ins);
+        this_edit[t+1] = {extended(this_edit[t][0], ins)};
+    }
+    for (size_t s = 0; s < source.size(); ++s) {
+        EditPair del({source[s]}, {});
+        next_row[0] = this_row[0] + ws.get_weight(del);
+        next_edit[0] = {extended(this_edit[0][0], del)};
+        for (size_t t = 0; t < tlen; ++t) {
+            EditPair ins({}, {target[t]}), sub({source[s]}, {target[t]});
+            double ins_cost = next_row[t] + ws.get_weight(ins),
+                   del_cost = this_row[t+1] + ws.get_weight(del),
+                   sub_cost = this_row[t] + ws.get_weight(sub),
+                   best = std::min({ins_cost, del_cost, sub_cost});
+            next_row[t+1] = best;
+            AlignmentSet& cell = next_edit[t+1];
+            cell.clear();
+            if (ins_cost <= best)
+                for (const auto& rs : next_edit[t])
+                    cell.push_back(extended(rs, ins));
+            if (del_cost <= best)
+                for (const auto& rs : this_edit[t+1])
+                    cell.push_back(extended(rs, del));
+            if (sub_cost <= best)
+                for (const auto& rs : this_edit[t])
+                    cell.push_back(extended(rs, sub));
+        }
+        this_row.swap(next_row);
+        this_edit.swap(next_edit);
+    }
+    return this_edit[tlen];
+}
+
 struct LevenshteinAlgorithmFixture {
     WeightSet ws;
 
@@ -235,6 +330,87 @@ BOOST_AUTO_TEST_CASE(la_align3) {
                 || (result_a == expected_b && result_b == expected_a));
 }
 
+BOOST_AUTO_TEST_CASE(la_align_leading_deletions) {
+    AlignmentSet set = align("abc", "c", WeightSet());
+    BOOST_REQUIRE_EQUAL(set.size(), 1);
+    RuleSet expected {EditPair({"a"}, {}), EditPair({"b"}, {}),
+                      EditPair({"c"}, {"c"})};
+    BOOST_CHECK(set.at(0) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(la_graph) {
+    AlignmentGraph graph(WordPair("a", "bc"), ws);
+    BOOST_CHECK_EQUAL(graph.count(), 2);
+    AlignmentSet set;
+    graph.for_each([&set](const RuleSet& rs) { set.push_back(rs); });
+    BOOST_CHECK(set == align("a", "bc", ws));
+    std::map<EditPair, uint64_t> expected
+        {{EditPair({"a"}, {"b"}), 1}, {EditPair({}, {"c"}), 1},
+         {EditPair({}, {"b"}), 1},    {EditPair({"a"}, {"c"}), 1}},
+        given;
+    graph.count_edits([&given](const EditPair& ep, uint64_t n) {
+        given[ep] += n;
+    });
+    BOOST_CHECK(given == expected);
+}
+
+BOOST_AUTO_TEST_CASE(la_graph_matches_sets) {
+    WeightSet expensive;
+    expensive.default_replacement_cost() = 3.0;
+    const std::vector<WordPair> pairs {
+        {"a", "bc"}, {"abc", "c"}, {"xxab", "ab"}, {"vnnd", "und"},
+        {"jnx", "im"}, {"abcd", ""}, {"", "ab"}, {"aab", "bba"},
+        {"abcde", "xy"}};
+    for (const WeightSet* weights : {&ws, &expensive}) {
+        for (const WordPair& p : pairs) {
+            AlignmentSet expected = set_based_align(p, *weights);
+            BOOST_CHECK(align(p, *weights) == expected);
+            AlignmentGraph graph(p, *weights);
+            BOOST_CHECK_EQUAL(graph.count(), expected.size());
+            std::map<EditPair, uint64_t> edits, expected_edits;
+            for (const RuleSet& rs : expected)
+                for (const EditPair& ep : rs)
+                    ++expected_edits[ep];
+            graph.count_edits([&edits](const EditPair& ep, uint64_t n) {
+                edits[ep] += n;
+            });
+            BOOST_CHECK(edits == expected_edits);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(la_graph_many_ties) {
+    // after the first character, every way to delete all of the source
+    // and insert all of the target is optimal
+    WeightSet expensive;
+    expensive.default_replacement_cost() = 3.0;
+    AlignmentGraph graph(WordPair("caaaaaaaaaa", "cbbbbbbbbbb"), expensive);
+    BOOST_CHECK_EQUAL(graph.count(), 184756);  // 20 choose 10
+    uint64_t deletions = 0;
+    graph.count_edits([&deletions](const EditPair& ep, uint64_t n) {
+        if (ep.second.empty())
+            deletions += n;
+    });
+    BOOST_CHECK_EQUAL(deletions, 10 * graph.count());
+}
+
+BOOST_AUTO_TEST_CASE(la_graph_count_saturates) {
+    // 80 choose 40 alignments don't fit into 64 bits
+    WeightSet expensive;
+    expensive.default_replacement_cost() = 3.0;
+    std::string source = "c" + std::string(40, 'a'),
+                target = "c" + std::string(40, 'b');
+    AlignmentGraph graph(WordPair(source.c_str(), target.c_str()), expensive);
+    const uint64_t max = std::numeric_limits<uint64_t>::max();
+    BOOST_CHECK_EQUAL(graph.count(), max);
+    uint64_t identity = 0;
+    graph.count_edits([&identity](const EditPair& ep, uint64_t n) {
+        if (ep.first == ep.second)
+            identity = n;
+    });
+    BOOST_CHECK_EQUAL(identity, max);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 //////// LevenshteinAligner ////////////////////////////////////////////////////
@@ -261,6 +437,59 @@ BOOST_AUTO_TEST_CASE(aligner_check_defaults) {
     BOOST_CHECK(aligner->weight_set().empty());
 }
 
+BOOST_AUTO_TEST_CASE(aligner_training_cycle) {
+    TrainSet pairs {{WordPair("ja", "ia"), 2}};
+    aligner->perform_training_cycle(pairs);
+    // the identity a:a is counted, but not learned
+    BOOST_CHECK_EQUAL(aligner->weight_set().size(), 1);
+    BOOST_CHECK_CLOSE(aligner->weight_set().get_weight("j", "i"), 1.0, 0.001);
+    BOOST_CHECK_CLOSE(aligner->meandiff(), 0.0, 0.001);
+}
+
+BOOST_AUTO_TEST_CASE(aligner_final_weights) {
+    TrainSet pairs {
+        {WordPair("vnd", "und"), 3}, {WordPair("vnnd", "und"), 1},
+        {WordPair("jn", "in"), 2},   {WordPair("jhm", "ihm"), 1},
+        {WordPair("frawe", "frau"), 1}, {WordPair("seyn", "sein"), 2},
+        {WordPair("thuen", "tun"), 1},  {WordPair("vber", "uber"), 1},
+        {WordPair("xxab", "ab"), 1},    {WordPair("ewig", "ewig"), 1}};
+    for (int cycle = 0; cycle < 3; ++cycle)
+        aligner->perform_training_cycle(pairs);
+    WeightSet final = aligner->make_final_weight_set(pairs), expected;
+    expected.read_paramfile(TEST_ALIGNER_WEIGHTSFILE);
+    BOOST_REQUIRE_EQUAL(final.size(), expected.size());
+    for (const auto& w : final.weight_map()) {
+        BOOST_REQUIRE(expected.weight_map().count(w.first) > 0);
+        BOOST_CHECK_CLOSE(w.second, expected.weight_map().at(w.first),
+                          0.001);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(aligner_threads_same_weights) {
+    TrainSet pairs;
+    const std::vector<string_impl> sources {"jn", "vnd", "jhm", "vnnd",
+                                            "jar", "frawe", "wyr", "ain"},
+                                   targets {"in", "und", "ihm", "und",
+                                            "jahr", "frau", "wir", "ein"};
+    for (int i = 0; i < 5; ++i)
+        for (size_t j = 0; j < sources.size(); ++j)
+            pairs[WordPair(sources[j] + sources[(j + i) % sources.size()],
+                           targets[j] + targets[(j + i) % targets.size()])]
+                = 1 + i;
+    LevenshteinAligner serial(ws, 3, 7), parallel(ws, 3, 7);
+    serial.threads() = 1;
+    parallel.threads() = 4;
+    for (int cycle = 0; cycle < 3; ++cycle) {
+        serial.perform_training_cycle(pairs);
+        parallel.perform_training_cycle(pairs);
+        BOOST_CHECK_EQUAL(serial.meandiff(), parallel.meandiff());
+        BOOST_CHECK(serial.weight_set().weight_map()
+                    == parallel.weight_set().weight_map());
+    }
+    BOOST_CHECK(serial.make_final_weight_set(pairs).weight_map()
+                == parallel.make_final_weight_set(pairs).weight_map());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 //////// WLD normalizer ////////////////////////////////////////////////////////
@@ -363,6 +592,18 @@ BOOST_AUTO_TEST_CASE(wld_normalize_4) {
     BOOST_CHECK_EQUAL(result.score, 0);
 }
 
+BOOST_AUTO_TEST_CASE(wld_normalize_symbols) {
+    Norma::Normalizer::SymbolString symbols;
+    w->set_caching(false);
+    for (const string_impl word : {"jn", "unnd", "jxa", "j", "jü"}) {
+        Norma::Normalizer::SymbolTable::global().intern(word, &symbols);
+        Result given = (*w)(word, symbols),
+               expected = (*w)(word);
+        BOOST_CHECK_EQUAL(given.word, expected.word);
+        BOOST_CHECK_CLOSE(given.score, expected.score, 0.001);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(wld_normalize_n_best) {
     ResultSet given = (*w)("jn", 5);
     ResultSet expected {Result("in", 0.818731),
@@ -378,6 +619,49 @@ BOOST_AUTO_TEST_CASE(wld_normalize_n_best) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(wld_native_engine) {
+    // the native engine needs a deterministic lexicon
+    lex->optimize();
+    w->init();
+    w->set_caching(false);
+    std::vector<string_impl> words {"in", "jn", "jhn", "jm", "und", "unnd",
+                                    "ja", "jxa", "jaf", "j", "jü"};
+    std::vector<Result> expected;
+    for (const string_impl& word : words)
+        expected.push_back((*w)(word));
+    w->set_engine(WLD::Engine::NATIVE);
+    w->init();
+    for (size_t i = 0; i < words.size(); ++i) {
+        Result given = (*w)(words[i]);
+        BOOST_CHECK_EQUAL(given.word, expected[i].word);
+        BOOST_CHECK_CLOSE(given.score, expected[i].score, 0.001);
+    }
+    ResultSet given = (*w)("jn", 5);
+    ResultSet expected_n {Result("in", 0.818731),
+                          Result("ihn", 0.449329),
+                          Result("an", 0.367879),
+                          Result("ihm", 0.182684)};
+    BOOST_REQUIRE_EQUAL(given.size(), expected_n.size());
+    for (size_t i = 0; i < expected_n.size(); ++i) {
+        BOOST_CHECK_EQUAL(given[i].word, expected_n[i].word);
+        BOOST_CHECK_CLOSE(given[i].score, expected_n[i].score, 0.001);
+        BOOST_CHECK_EQUAL(given[i].origin, "WLD");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(wld_engine_param) {
+    std::map<std::string, std::string> params;
+    params["WLD.paramfile"] = TEST_WEIGHTSFILE;
+    params["WLD.engine"] = "native";
+    w->init(params, lex);
+    BOOST_CHECK(w->get_engine() == WLD::Engine::NATIVE);
+    params["WLD.engine"] = "gfsm";
+    w->init(params, lex);
+    BOOST_CHECK(w->get_engine() == WLD::Engine::GFSM);
+    params["WLD.engine"] = "fastest";
+    BOOST_CHECK_THROW(w->init(params, lex), Norma::Normalizer::init_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(WLD2)
@@ -38,6 +38,8 @@ class RulebasedTest(unittest.TestCase, AssertFloat):
         self.assertTrue(self.norm.caching)
         self.norm.caching = False
         self.assertFalse(self.norm.caching)
+        self.norm.cache_size = 500
+        self.assertEquals(self.norm.cache_size, 500)
 
     def testNormalize1(self):
         self.norm.rulesfile = self.rulesfile
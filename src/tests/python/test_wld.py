@@ -44,6 +44,8 @@ class WLDTest(unittest.TestCase, AssertFloat):
         self.assertTrue(self.norm.caching)
         self.norm.caching = False
         self.assertFalse(self.norm.caching)
+        self.norm.cache_size = 500
+        self.assertEquals(self.norm.cache_size, 500)
 
     def testProperties3(self):
         self.norm.ngrams  = 2
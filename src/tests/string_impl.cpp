@@ -0,0 +1,136 @@
+/* Copyright 2013-2015 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE StringImpl
+#include<atomic>
+#include<set>
+#include<sstream>
+#include<string>
+#include<boost/test/included/unit_test.hpp>  // NOLINT[build/include_order]
+#include"string_impl.h"
+
+BOOST_AUTO_TEST_SUITE(StringImpl1)
+
+BOOST_AUTO_TEST_CASE(string_impl_from_char) {
+    string_impl word = "wort";
+    BOOST_CHECK(from_char(word[0]) == "w");
+    BOOST_CHECK(from_char(' ') == " ");
+}
+
+BOOST_AUTO_TEST_CASE(string_impl_extract) {
+    string_impl word = "zweitens", out;
+    extract(word, 2, 5, &out);
+    BOOST_CHECK(out == "eit");
+    extract_tail(word, 4, &out);
+    BOOST_CHECK(out == "tens");
+    extract(word, 0, word.length(), &out);
+    BOOST_CHECK(out == word);
+}
+
+BOOST_AUTO_TEST_CASE(string_impl_output) {
+    std::string text(300, 'x');
+    text += "ende";
+    string_impl word = text.c_str();
+    BOOST_CHECK_EQUAL(std::string(to_cstr(word)), text);
+    std::ostringstream out;
+    out << word;
+    BOOST_CHECK_EQUAL(out.str(), text);
+    std::string line = "a";
+    append_utf8(word, &line);
+    BOOST_CHECK_EQUAL(line, "a" + text);
+    BOOST_CHECK_EQUAL(to_utf8(word), text);
+}
+
+#if defined(USE_ICU_STRING) || defined(USE_UTF8_STRING)
+BOOST_AUTO_TEST_CASE(string_impl_unicode) {
+    string_impl word = "naß";
+    BOOST_CHECK_EQUAL(word.length(), 3);
+    BOOST_CHECK(word[2] == 0xDF);
+    BOOST_CHECK(check_if_alpha(word[2]));
+    BOOST_CHECK(from_char(word[2]) == "ß");
+    string_impl out;
+    extract(word, 1, 3, &out);
+    BOOST_CHECK(out == "aß");
+    std::ostringstream strm;
+    strm << word;
+    BOOST_CHECK_EQUAL(strm.str(), "naß");
+}
+#endif
+
+#ifdef USE_UTF8_STRING
+BOOST_AUTO_TEST_CASE(utf8_string_index) {
+    // long enough to go past the offset table and the inline buffer
+    string_impl word;
+    for (int i = 0; i < 40; ++i)
+        word += (i % 2 == 0) ? U'ſ' : U'e';
+    BOOST_CHECK_EQUAL(word.length(), 40);
+    BOOST_CHECK_EQUAL(word.bytes(), 60);
+    BOOST_CHECK(word[38] == U'ſ');
+    BOOST_CHECK(word[39] == U'e');
+    string_impl out;
+    extract(word, 37, 40, &out);
+    BOOST_CHECK(out == "eſe");
+    BOOST_CHECK_EQUAL(word.find("ſeſ"), 0);
+    BOOST_CHECK_EQUAL(string_impl("äbc").find("c"), 2);
+}
+
+BOOST_AUTO_TEST_CASE(utf8_string_invalid) {
+    string_impl word("a\xff" "b", 3);
+    BOOST_CHECK_EQUAL(word.length(), 3);
+    BOOST_CHECK(word[1] == 0xFFFD);
+    BOOST_CHECK(word[2] == 'b');
+}
+
+BOOST_AUTO_TEST_CASE(utf8_string_order) {
+    std::set<string_impl> words {"b", "ä", "a", "ab"};
+    auto it = words.begin();
+    BOOST_CHECK(*it++ == "a");
+    BOOST_CHECK(*it++ == "ab");
+    BOOST_CHECK(*it++ == "b");
+    BOOST_CHECK(*it++ == "ä");
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(dense_char_map) {
+    string_impl word = "naß";
+    DenseCharMap<int> map;
+    BOOST_CHECK(map.slot(word[0]) == nullptr);
+    BOOST_CHECK_EQUAL(map.get(word[0]), 0);
+    map[word[0]] = 1;
+    map[word[2]] = 3;
+    BOOST_CHECK_EQUAL(map.get(word[0]), 1);
+    BOOST_CHECK_EQUAL(map.get(word[1]), 0);
+    BOOST_CHECK_EQUAL(map.get(word[2]), 3);
+#if defined(USE_ICU_STRING) || defined(USE_UTF8_STRING)
+    const char_impl wide = 0x1F600;
+    BOOST_CHECK(!DenseCharMap<int>::is_dense(wide));
+    BOOST_CHECK(map.slot(wide) == nullptr);
+    map[wide] = 4;
+    BOOST_CHECK_EQUAL(map.get(wide), 4);
+#endif
+    map.clear();
+    BOOST_CHECK_EQUAL(map.get(word[0]), 0);
+    // atomics can't be moved, so all slots exist from the start
+    DenseCharMap<std::atomic<int>> ids;
+    BOOST_REQUIRE(ids.slot(word[0]) != nullptr);
+    BOOST_CHECK_EQUAL(ids.slot(word[0])->load(), 0);
+    ids[word[2]].store(5);
+    BOOST_CHECK_EQUAL(ids.slot(word[2])->load(), 5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,117 @@
+/* Copyright 2013-2015 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE ThreadPool
+#include<atomic>
+#include<chrono>
+#include<future>
+#include<set>
+#include<stdexcept>
+#include<thread>
+#include<vector>
+#include<boost/test/included/unit_test.hpp>  // NOLINT[build/include_order]
+#include"thread_pool.h"
+#include"results_queue.h"
+#include"string_impl.h"
+
+BOOST_AUTO_TEST_SUITE(ThreadPool1)
+
+BOOST_AUTO_TEST_CASE(thread_pool_size) {
+    Norma::ThreadPool pool(3);
+    BOOST_CHECK_EQUAL(pool.size(), 3);
+    Norma::ThreadPool default_pool;
+    BOOST_CHECK(default_pool.size() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool_submit) {
+    Norma::ThreadPool pool(4, 2);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; ++i)
+        results.push_back(pool.submit([i]() { return i * i; }));
+    for (int i = 0; i < 100; ++i)
+        BOOST_CHECK_EQUAL(results[i].get(), i * i);
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool_reuses_workers) {
+    std::mutex ids_mutex;
+    std::set<std::thread::id> ids;
+    {
+        Norma::ThreadPool pool(2);
+        for (int i = 0; i < 50; ++i)
+            pool.post([&ids, &ids_mutex]() {
+                std::lock_guard<std::mutex> guard(ids_mutex);
+                ids.insert(std::this_thread::get_id());
+            });
+    }  // the dtor finishes all queued tasks
+    BOOST_CHECK(ids.size() <= 2);
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool_exception) {
+    Norma::ThreadPool pool(1);
+    auto result = pool.submit([]() -> int {
+        throw std::runtime_error("foo");
+    });
+    BOOST_CHECK_THROW(result.get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(results_queue_order) {
+    Norma::ThreadPool pool(4);
+    std::vector<string_impl> output;
+    Norma::ResultsQueue<string_impl> queue(&pool);
+    queue.set_consumer([&output](string_impl r) { output.push_back(r); });
+    std::vector<string_impl> input { "foo", "bar", "baz", "bla" };
+    for (int i = 0; i < 25; ++i)
+        for (const auto& word : input)
+            queue.add_producer([](string_impl w) { return w; }, word);
+    queue.finish();
+    BOOST_REQUIRE_EQUAL(output.size(), 100);
+    for (size_t i = 0; i < output.size(); ++i)
+        BOOST_CHECK_EQUAL(output[i], input[i % input.size()]);
+}
+
+BOOST_AUTO_TEST_CASE(results_queue_small_ring) {
+    // more producers than fit in the ring, finishing out of order
+    Norma::ThreadPool pool(4);
+    std::vector<int> output;
+    Norma::ResultsQueue<int> queue(&pool, 3);
+    queue.set_consumer([&output](int r) { output.push_back(r); });
+    for (int i = 0; i < 200; ++i)
+        queue.add_producer([i]() {
+            std::this_thread::sleep_for(std::chrono::microseconds(
+                (i % 7) * 100));
+            return i;
+        });
+    queue.finish();
+    BOOST_REQUIRE_EQUAL(output.size(), 200);
+    for (int i = 0; i < 200; ++i)
+        BOOST_CHECK_EQUAL(output[i], i);
+}
+
+BOOST_AUTO_TEST_CASE(results_queue_exception) {
+    Norma::ThreadPool pool(2);
+    std::vector<int> output;
+    Norma::ResultsQueue<int> queue(&pool);
+    queue.set_consumer([&output](int r) { output.push_back(r); });
+    queue.add_producer([]() { return 1; });
+    queue.add_producer([]() -> int { throw std::runtime_error("foo"); });
+    BOOST_CHECK_THROW(queue.finish(), std::runtime_error);
+    BOOST_REQUIRE_EQUAL(output.size(), 1);
+    BOOST_CHECK_EQUAL(output[0], 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,75 @@
+/* Copyright 2013-2015 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include"thread_pool.h"
+#include<functional>
+#include<mutex>
+#include<thread>
+#include<utility>
+
+namespace Norma {
+ThreadPool::ThreadPool(unsigned num_threads, size_t max_queued) {
+    if (num_threads == 0)
+        num_threads = std::thread::hardware_concurrency();
+    // hardware_concurrency may return 0 if it can't tell
+    if (num_threads == 0)
+        num_threads = 1;
+    _max_queued = (max_queued == 0) ? 2 * num_threads : max_queued;
+    for (unsigned i = 0; i < num_threads; ++i)
+        _workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    task_available.notify_all();
+    for (auto& worker : _workers)
+        worker.join();
+}
+
+void ThreadPool::post(std::function<void()> task) {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        slot_available.wait(lock, [this] {
+            return _tasks.size() < _max_queued;
+        });
+        _tasks.push_back(std::move(task));
+    }
+    task_available.notify_one();
+}
+
+void ThreadPool::work() {
+    for (; ;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            task_available.wait(lock, [this] {
+                return _stopping || !_tasks.empty();
+            });
+            // drain the queue before stopping
+            if (_tasks.empty())
+                return;
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        slot_available.notify_one();
+        task();
+    }
+}
+}  // namespace Norma
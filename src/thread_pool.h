@@ -0,0 +1,71 @@
+/* Copyright 2013-2015 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+#include<condition_variable>
+#include<deque>
+#include<functional>
+#include<future>
+#include<mutex>
+#include<thread>
+#include<vector>
+
+namespace Norma {
+/// a fixed-size pool of worker threads
+/** Tasks are handed to the workers through a bounded queue. If the
+ *  queue is full, submitting a task blocks until a worker has picked
+ *  up one of the queued tasks, so the amount of pending work stays
+ *  bounded no matter how fast the producer is.
+ *
+ *  if num_threads is 0, it will be set to hardware_concurrency (the number
+ *  of threads that can physically be executed in parallel). if max_queued
+ *  is 0, it will be set to twice the number of threads.
+ *
+ *  Tasks must not submit further tasks to the same pool and then wait
+ *  for them, since this can deadlock once all workers are busy.
+ **/
+class ThreadPool {
+ public:
+     explicit ThreadPool(unsigned num_threads = 0, size_t max_queued = 0);
+     ThreadPool(const ThreadPool& a) = delete;
+     const ThreadPool& operator=(const ThreadPool& a) = delete;
+     /// finishes all queued tasks, then joins the workers
+     ~ThreadPool();
+
+     /// queue a task, blocking while the queue is full
+     void post(std::function<void()> task);
+     /// queue a task and return a future for its result
+     template<typename F>
+     std::future<typename std::result_of<F()>::type> submit(F task);
+     /// number of worker threads
+     unsigned size() const { return _workers.size(); }
+
+ private:
+     void work();
+
+     std::vector<std::thread> _workers;
+     std::deque<std::function<void()>> _tasks;
+     size_t _max_queued;
+     bool _stopping = false;
+     std::mutex _mutex;
+     std::condition_variable task_available, slot_available;
+};
+}  // namespace Norma
+
+#include"thread_pool-inl.h"
+#endif  // THREAD_POOL_H_
@@ -0,0 +1,226 @@
+/* Copyright 2013-2015 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include"utf8_string.h"
+#include<algorithm>
+#include<cstring>
+#include<istream>
+#include<string>
+
+namespace {
+/// length of the sequence starting at p, 1 for invalid sequences
+inline size_t sequence_length(const unsigned char* p,
+                              const unsigned char* end) {
+    size_t len = p[0] < 0xC0 ? 1
+               : p[0] < 0xE0 ? 2
+               : p[0] < 0xF0 ? 3
+               : p[0] < 0xF8 ? 4 : 1;
+    if (len > static_cast<size_t>(end - p))
+        return 1;
+    for (size_t i = 1; i < len; ++i) {
+        if ((p[i] & 0xC0) != 0x80)
+            return 1;
+    }
+    return len;
+}
+
+inline char32_t decode(const unsigned char* p, size_t len) {
+    switch (len) {
+    case 2:
+        return ((p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+    case 3:
+        return ((p[0] & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+    case 4:
+        return ((p[0] & 0x07) << 18) | ((p[1] & 0x3F) << 12)
+             | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+    default:
+        return p[0] < 0x80 ? p[0] : 0xFFFD;
+    }
+}
+
+/// writes c to out, returns the number of bytes
+inline size_t encode(char32_t c, char* out) {
+    if (c > 0x10FFFF || (c >= 0xD800 && c < 0xE000))
+        c = 0xFFFD;
+    if (c < 0x80) {
+        out[0] = static_cast<char>(c);
+        return 1;
+    } else if (c < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (c >> 6));
+        out[1] = static_cast<char>(0x80 | (c & 0x3F));
+        return 2;
+    } else if (c < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (c >> 12));
+        out[1] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (c & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (c >> 18));
+    out[1] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (c & 0x3F));
+    return 4;
+}
+}  // namespace
+
+utf8_string_impl::utf8_string_impl(char32_t c) : utf8_string_impl() {
+    char tmp[4];
+    assign(tmp, encode(c, tmp));
+}
+
+char32_t utf8_string_impl::operator[](size_t i) const {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data());
+    if (is_ascii())
+        return p[i];
+    const unsigned char* end = p + _bytes;
+    p += offset(i);
+    return decode(p, sequence_length(p, end));
+}
+
+size_t utf8_string_impl::offset(size_t i) const {
+    if (i >= _chars)
+        return _bytes;
+    if (is_ascii())
+        return i;
+    if (has_index())
+        return _index[i];
+    const unsigned char* begin =
+        reinterpret_cast<const unsigned char*>(data());
+    const unsigned char* p = begin;
+    const unsigned char* end = begin + _bytes;
+    for (; i > 0; --i)
+        p += sequence_length(p, end);
+    return p - begin;
+}
+
+void utf8_string_impl::index_from(size_t from) {
+    const unsigned char* begin =
+        reinterpret_cast<const unsigned char*>(data());
+    const unsigned char* end = begin + _bytes;
+    for (const unsigned char* p = begin + from; p < end; ++_chars) {
+        if (_chars < INDEX_CHARS && p - begin < 256)
+            _index[_chars] = p - begin;
+        if (*p < 0x80) {
+            ++p;
+        } else {
+            _ascii = false;
+            p += sequence_length(p, end);
+        }
+    }
+}
+
+utf8_string_impl& utf8_string_impl::assign(const char* str, size_t len) {
+    if (len > _capacity) {
+        // str may point into the old buffer
+        char* heap = new char[len + 1];
+        std::memcpy(heap, str, len);
+        delete[] _heap;
+        _heap = heap;
+        _capacity = len;
+    } else {
+        std::memmove(buffer(), str, len);
+    }
+    buffer()[len] = 0;
+    _bytes = len;
+    _chars = 0;
+    _ascii = true;
+    index_from(0);
+    return *this;
+}
+
+utf8_string_impl& utf8_string_impl::append(const char* str, size_t len) {
+    size_t old = _bytes;
+    if (old + len > _capacity) {
+        size_t capacity = std::max(old + len,
+                                   2 * static_cast<size_t>(_capacity));
+        char* heap = new char[capacity + 1];
+        std::memcpy(heap, data(), old);
+        std::memcpy(heap + old, str, len);
+        delete[] _heap;
+        _heap = heap;
+        _capacity = capacity;
+    } else {
+        std::memmove(buffer() + old, str, len);
+    }
+    buffer()[old + len] = 0;
+    _bytes = old + len;
+    index_from(old);
+    return *this;
+}
+
+utf8_string_impl& utf8_string_impl::operator+=(char32_t c) {
+    char tmp[4];
+    return append(tmp, encode(c, tmp));
+}
+
+void utf8_string_impl::swap(utf8_string_impl& that) {
+    std::swap(_heap, that._heap);
+    std::swap(_bytes, that._bytes);
+    std::swap(_chars, that._chars);
+    std::swap(_capacity, that._capacity);
+    std::swap(_ascii, that._ascii);
+    std::swap(_index, that._index);
+    std::swap(_sso, that._sso);
+}
+
+void utf8_string_impl::extract(size_t from, size_t to,
+                               utf8_string_impl* out) const {
+    size_t begin = offset(from), end = offset(std::max(from, to));
+    out->assign(data() + begin, end - begin);
+}
+
+size_t utf8_string_impl::find(const char* str) const {
+    const char* begin = data();
+    const char* end = begin + _bytes;
+    const char* pos = std::search(begin, end, str, str + std::strlen(str));
+    if (pos == end && *str != 0)
+        return npos;
+    if (is_ascii())
+        return pos - begin;
+    size_t chars = 0;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(begin);
+    const unsigned char* stop = reinterpret_cast<const unsigned char*>(pos);
+    for (; p < stop; ++chars)
+        p += sequence_length(p, reinterpret_cast<const unsigned char*>(end));
+    return chars;
+}
+
+int utf8_string_impl::compare(const char* str, size_t len) const {
+    int result = std::memcmp(data(), str, std::min<size_t>(_bytes, len));
+    if (result != 0)
+        return result;
+    return _bytes < len ? -1 : (_bytes > len ? 1 : 0);
+}
+
+std::istream& operator>>(std::istream& strm, utf8_string_impl& val) {
+    std::string str;
+    strm >> str;
+    val.assign(str.data(), str.size());
+    return strm;
+}
+
+size_t std::hash<utf8_string_impl>::operator()(
+        const utf8_string_impl& str) const {
+    // FNV-1a
+    size_t h = static_cast<size_t>(14695981039346656037ULL);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(str.data());
+    for (size_t i = 0; i < str.bytes(); ++i) {
+        h ^= p[i];
+        h *= static_cast<size_t>(1099511628211ULL);
+    }
+    return h;
+}
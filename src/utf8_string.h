@@ -0,0 +1,168 @@
+/* Copyright 2013-2015 Marcel Bollmann, Florian Petran
+ *
+ * This file is part of Norma.
+ *
+ * Norma is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Norma is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along
+ * with Norma.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UTF8_STRING_H_
+#define UTF8_STRING_H_
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<functional>
+#include<istream>
+#include<ostream>
+#include<string>
+
+/// A UTF-8 encoded string that counts and indexes code points.
+/** Strings of up to SSO_BYTES bytes are stored inside the object, so
+ *  single characters and most words never allocate. Indexing a code
+ *  point is O(1) for ASCII strings, and for strings of up to
+ *  INDEX_CHARS code points, whose byte offsets are kept in a small
+ *  table that's updated whenever the string changes. Longer strings
+ *  with non-ASCII characters are decoded from the start.
+ *
+ *  Invalid UTF-8 bytes count as one code point each and read as
+ *  U+FFFD. Comparison is bytewise, which is code point order.
+ **/
+class utf8_string_impl {
+ public:
+     static const size_t npos = static_cast<size_t>(-1);
+     static const size_t SSO_BYTES   = 23;
+     static const size_t INDEX_CHARS = 24;
+
+     utf8_string_impl() { _sso[0] = 0; }
+     utf8_string_impl(const char* str)  // NOLINT[runtime/explicit]
+         : utf8_string_impl() { assign(str, std::strlen(str)); }
+     utf8_string_impl(const char* str, size_t len)
+         : utf8_string_impl() { assign(str, len); }
+     utf8_string_impl(const std::string& str)  // NOLINT[runtime/explicit]
+         : utf8_string_impl() { assign(str.data(), str.size()); }
+     utf8_string_impl(char32_t c);  // NOLINT[runtime/explicit]
+     utf8_string_impl(const utf8_string_impl& that)
+         : utf8_string_impl() { assign(that.data(), that._bytes); }
+     utf8_string_impl(utf8_string_impl&& that) : utf8_string_impl() {
+         swap(that);
+     }
+     utf8_string_impl& operator=(const utf8_string_impl& that) {
+         if (this != &that)
+             assign(that.data(), that._bytes);
+         return *this;
+     }
+     utf8_string_impl& operator=(utf8_string_impl&& that) {
+         swap(that);
+         return *this;
+     }
+     ~utf8_string_impl() { delete[] _heap; }
+
+     /// number of code points
+     size_t length() const { return _chars; }
+     /// number of bytes
+     size_t bytes() const { return _bytes; }
+     bool empty() const { return _bytes == 0; }
+     const char* data() const { return _heap != nullptr ? _heap : _sso; }
+     const char* c_str() const { return data(); }
+     std::string str() const { return std::string(data(), _bytes); }
+
+     /// the i-th code point
+     char32_t operator[](size_t i) const;
+     /// byte offset of the i-th code point, or bytes() if i >= length()
+     size_t offset(size_t i) const;
+
+     utf8_string_impl& assign(const char* str, size_t len);
+     utf8_string_impl& append(const char* str, size_t len);
+     utf8_string_impl& operator+=(const utf8_string_impl& that) {
+         return append(that.data(), that._bytes);
+     }
+     utf8_string_impl& operator+=(const char* str) {
+         return append(str, std::strlen(str));
+     }
+     utf8_string_impl& operator+=(char32_t c);
+     void clear() { assign("", 0); }
+     void swap(utf8_string_impl& that);
+
+     /// copy code points [from, to) to out, reusing its buffer
+     void extract(size_t from, size_t to, utf8_string_impl* out) const;
+     /// index of the first code point where str occurs, or npos
+     size_t find(const char* str) const;
+     int compare(const char* str, size_t len) const;
+     int compare(const utf8_string_impl& that) const {
+         return compare(that.data(), that._bytes);
+     }
+
+ private:
+     bool is_ascii() const { return _ascii; }
+     bool has_index() const { return _chars <= INDEX_CHARS && _bytes < 256; }
+     char* buffer() { return _heap != nullptr ? _heap : _sso; }
+     /// count and index the code points from byte offset from on
+     void index_from(size_t from);
+
+     char* _heap = nullptr;
+     uint32_t _bytes = 0;
+     uint32_t _chars = 0;
+     uint32_t _capacity = SSO_BYTES;
+     bool _ascii = true;
+     uint8_t _index[INDEX_CHARS];
+     char _sso[SSO_BYTES + 1];
+};
+
+inline bool operator==(const utf8_string_impl& a, const utf8_string_impl& b) {
+    return a.bytes() == b.bytes()
+        && std::memcmp(a.data(), b.data(), a.bytes()) == 0;
+}
+inline bool operator==(const utf8_string_impl& a, const char* b) {
+    return a.compare(b, std::strlen(b)) == 0;
+}
+inline bool operator==(const char* a, const utf8_string_impl& b) {
+    return b == a;
+}
+inline bool operator!=(const utf8_string_impl& a, const utf8_string_impl& b) {
+    return !(a == b);
+}
+inline bool operator!=(const utf8_string_impl& a, const char* b) {
+    return !(a == b);
+}
+inline bool operator!=(const char* a, const utf8_string_impl& b) {
+    return !(b == a);
+}
+inline bool operator<(const utf8_string_impl& a, const utf8_string_impl& b) {
+    return a.compare(b) < 0;
+}
+inline bool operator>(const utf8_string_impl& a, const utf8_string_impl& b) {
+    return b < a;
+}
+inline bool operator<=(const utf8_string_impl& a, const utf8_string_impl& b) {
+    return !(b < a);
+}
+inline bool operator>=(const utf8_string_impl& a, const utf8_string_impl& b) {
+    return !(a < b);
+}
+inline utf8_string_impl operator+(utf8_string_impl a,
+                                  const utf8_string_impl& b) {
+    return a += b;
+}
+
+std::istream& operator>>(std::istream& strm, utf8_string_impl& val);
+inline std::ostream& operator<<(std::ostream& strm,
+                                const utf8_string_impl& val) {
+    return strm.write(val.data(), val.bytes());
+}
+
+namespace std {
+template<> struct hash<utf8_string_impl> {
+    size_t operator()(const utf8_string_impl& str) const;
+};
+}  // namespace std
+
+#endif  // UTF8_STRING_H_